@@ -0,0 +1,254 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Асинхронное выполнение операций над матрицами
+
+#ifndef __TAsync_H__
+#define __TAsync_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "tmatrix.h"
+
+// Дескриптор асинхронной операции -
+// аналог std::shared_future с обратными вызовами.
+// Операции выполняются в общем пуле потоков; ожидающий поток
+// сам выполняет задачи пула, поэтому ожидание не занимает поток впустую
+// и не приводит к взаимоблокировке при одном потоке в пуле.
+template<typename R>
+class TAsyncHandle
+{
+    using Value = std::conditional_t<std::is_void<R>::value, char, R>;
+
+    struct TState
+    {
+        std::mutex mutex;
+        std::condition_variable done;
+        bool ready = false;
+        std::optional<Value> value;
+        std::exception_ptr error;
+        std::vector<std::function<void()>> callbacks;
+    };
+
+    std::shared_ptr<TState> st;
+
+    template<typename F>
+    friend auto Async(F f);
+
+    explicit TAsyncHandle(std::shared_ptr<TState> s) : st(std::move(s)) {}
+
+    template<typename F>
+    static void run(const std::shared_ptr<TState>& s, F& f)
+    {
+        try
+        {
+            if constexpr (std::is_void<R>::value)
+            {
+                f();
+                s->value.emplace();
+            }
+            else
+                s->value.emplace(f());
+        }
+        catch (...)
+        {
+            s->error = std::current_exception();
+        }
+
+        std::vector<std::function<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            s->ready = true;
+            callbacks.swap(s->callbacks);
+        }
+        s->done.notify_all();
+        for (auto& c : callbacks)
+            c();
+    }
+
+public:
+    TAsyncHandle() = default;
+
+    bool IsValid() const noexcept
+    {
+        return st != nullptr;
+    }
+    bool IsReady() const
+    {
+        if (!st)
+            throw logic_error("Async handle has no associated operation");
+        std::lock_guard<std::mutex> lock(st->mutex);
+        return st->ready;
+    }
+    void Wait() const
+    {
+        if (!st)
+            throw logic_error("Async handle has no associated operation");
+        TThreadPool& pool = TThreadPool::Instance();
+        while (!IsReady())
+        {
+            if (pool.TryRunOne())
+                continue;
+            std::unique_lock<std::mutex> lock(st->mutex);
+            st->done.wait_for(lock, std::chrono::milliseconds(1), [this] { return st->ready; });
+        }
+    }
+    // результат операции; исключение операции пробрасывается
+    decltype(auto) Get() const
+    {
+        Wait();
+        if (st->error)
+            std::rethrow_exception(st->error);
+        if constexpr (std::is_void<R>::value)
+            return;
+        else
+            return static_cast<const R&>(*st->value);
+    }
+    // callback(handle) вызывается по завершении в завершившем операцию потоке
+    // или сразу, если операция уже завершена
+    template<typename F>
+    void Then(F callback) const
+    {
+        if (!st)
+            throw logic_error("Async handle has no associated operation");
+        TAsyncHandle self = *this;
+        std::unique_lock<std::mutex> lock(st->mutex);
+        if (!st->ready)
+        {
+            st->callbacks.push_back([self, callback]() mutable { callback(self); });
+            return;
+        }
+        lock.unlock();
+        callback(self);
+    }
+};
+
+// Запуск f() в пуле потоков; f перемещается в задачу, не копируется,
+// поэтому f может быть некопируемым (задачи пула - std::function,
+// так что в задаче хранится указатель на f)
+template<typename F>
+auto Async(F f)
+{
+    using R = std::decay_t<decltype(f())>;
+    auto state = std::make_shared<typename TAsyncHandle<R>::TState>();
+    auto fn = std::make_shared<F>(std::move(f));
+    TThreadPool::Instance().Submit([state, fn] { TAsyncHandle<R>::run(state, *fn); });
+    return TAsyncHandle<R>(state);
+}
+
+template<typename R>
+void WaitAll(const std::vector<TAsyncHandle<R>>& handles)
+{
+    for (const auto& h : handles)
+        h.Wait();
+}
+template<typename... R>
+void WaitAll(const TAsyncHandle<R>&... handles)
+{
+    (handles.Wait(), ...);
+}
+
+// индекс первой завершившейся операции. Остальные операции не отменяются;
+// их обратные вызовы, добавленные WaitAny, остаются зарегистрированными
+// до завершения операций и тогда ничего не делают
+template<typename R>
+size_t WaitAny(const std::vector<TAsyncHandle<R>>& handles)
+{
+    if (handles.empty())
+        throw invalid_argument("WaitAny requires at least one handle");
+
+    struct TSignal
+    {
+        std::mutex mutex;
+        std::condition_variable done;
+        std::atomic<size_t> index{ static_cast<size_t>(-1) };
+    };
+    constexpr size_t none = static_cast<size_t>(-1);
+    auto signal = std::make_shared<TSignal>();
+    for (size_t i = 0; i < handles.size(); ++i)
+        handles[i].Then([signal, i](const TAsyncHandle<R>&) {
+            // после первого завершения - без блокировок и пробуждений
+            size_t expected = none;
+            if (!signal->index.compare_exchange_strong(expected, i))
+                return;
+            {
+                std::lock_guard<std::mutex> lock(signal->mutex);
+            }
+            signal->done.notify_all();
+        });
+
+    TThreadPool& pool = TThreadPool::Instance();
+    std::unique_lock<std::mutex> lock(signal->mutex);
+    while (signal->index.load() == none)
+    {
+        lock.unlock();
+        bool ran = pool.TryRunOne();
+        lock.lock();
+        if (!ran)
+            signal->done.wait_for(lock, std::chrono::milliseconds(1));
+    }
+    return signal->index.load();
+}
+
+// Асинхронные варианты тяжёлых операций; операнды передаются по значению
+// (их можно переместить), потоки ввода/вывода должны жить до завершения
+template<typename T>
+TAsyncHandle<TDynamicMatrix<T>> MultiplyAsync(TDynamicMatrix<T> a, TDynamicMatrix<T> b)
+{
+    return Async([a = std::move(a), b = std::move(b)]() mutable { return a * b; });
+}
+template<typename T>
+TAsyncHandle<TDynamicVector<T>> MultiplyAsync(TDynamicMatrix<T> a, TDynamicVector<T> v)
+{
+    return Async([a = std::move(a), v = std::move(v)]() mutable { return a * v; });
+}
+template<typename T>
+TAsyncHandle<TDynamicVector<T>> SolveAsync(TDynamicMatrix<T> a, TDynamicVector<T> b)
+{
+    return Async([a = std::move(a), b = std::move(b)]() { return a.Solve(exec_par, b); });
+}
+// варианты с отменой и крайним сроком (см. TOperationControl)
+template<typename T>
+TAsyncHandle<TDynamicMatrix<T>> MultiplyAsync(TDynamicMatrix<T> a, TDynamicMatrix<T> b, TOperationControl control)
+{
+    return Async([a = std::move(a), b = std::move(b), control = std::move(control)]() {
+        return a.multiply(exec_par, b, control);
+    });
+}
+template<typename T>
+TAsyncHandle<TDynamicVector<T>> SolveAsync(TDynamicMatrix<T> a, TDynamicVector<T> b, TOperationControl control)
+{
+    return Async([a = std::move(a), b = std::move(b), control = std::move(control)]() {
+        return a.Solve(exec_par, b, control);
+    });
+}
+template<typename T>
+TAsyncHandle<TDynamicMatrix<T>> ReadAsync(istream& istr, size_t size)
+{
+    return Async([&istr, size]() {
+        TDynamicMatrix<T> m(static_cast<int>(size));
+        if (!(istr >> m))
+            throw runtime_error("Failed to read matrix");
+        return m;
+    });
+}
+template<typename T>
+TAsyncHandle<void> WriteAsync(ostream& ostr, TDynamicMatrix<T> m)
+{
+    return Async([&ostr, m = std::move(m)]() {
+        if (!(ostr << m))
+            throw runtime_error("Failed to write matrix");
+    });
+}
+
+#endif
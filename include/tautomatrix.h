@@ -0,0 +1,321 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Матрица с автоматическим выбором представления
+
+#ifndef __TAutoMatrix_H__
+#define __TAutoMatrix_H__
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <variant>
+#include "tsparse.h"
+#include "tbanded.h"
+#include "utmatrix.h"
+#include "tdiagonal.h"
+
+// Структура квадратной матрицы: число ненулевых элементов, число
+// поддиагоналей (lower) и наддиагоналей (upper), содержащих ненулевые
+// элементы, и симметричность
+struct TMatrixStructure
+{
+    size_t size = 0;
+    size_t nonZeros = 0;
+    size_t lower = 0;
+    size_t upper = 0;
+    bool symmetric = true;
+
+    double Density() const noexcept
+    {
+        return size ? static_cast<double>(nonZeros) / (static_cast<double>(size) * size) : 0.0;
+    }
+};
+
+// Представления TAutoMatrix (в порядке альтернатив внутри TAutoMatrix)
+enum class TMatrixStorage { Dense, Sparse, Band, UpperTriangular, Symmetric, Diagonal };
+
+// Стоимость умножения на вектор в долях элемента плотной матрицы
+// (замеры SpMV, ленточного и упакованных ядер: n = 4000, double, один поток;
+// плотная - 1.8 нс на элемент). У CSR и ленты есть ещё расход на строку,
+// заметный при нескольких элементах в строке.
+const double STORAGE_COST_CSR_NONZERO = 1.0;
+const double STORAGE_COST_CSR_ROW = 7.0;
+const double STORAGE_COST_BAND_ELEMENT = 0.75;
+const double STORAGE_COST_BAND_ROW = 2.0;
+const double STORAGE_COST_UPPER_ELEMENT = 0.95;
+const double STORAGE_COST_SYMMETRIC_ELEMENT = 1.2;   // на хранимый элемент, каждый используется дважды
+
+// Структура плотной матрицы - один проход по строкам;
+// симметричность сравнивает строку i со столбцом i ниже диагонали
+template<typename Policy, typename T, enable_if_exec_policy_t<Policy> = 0>
+TMatrixStructure AnalyzeStructure(const Policy& policy, const TDynamicMatrix<T>& m)
+{
+    size_t n = m.GetSize();
+    TMatrixStructure init;
+    init.size = n;
+    return ReduceChunks(policy, n, std::max<size_t>(1, PARALLEL_MIN_CHUNK / n), init,
+        [&](size_t first, size_t last) {
+            TMatrixStructure s;
+            s.size = n;
+            for (size_t i = first; i < last; ++i)
+            {
+                const T* r = m[i].data();
+                for (size_t j = 0; j < n; ++j)
+                {
+                    if (r[j] == T())
+                        continue;
+                    ++s.nonZeros;
+                    if (j < i)
+                        s.lower = std::max(s.lower, i - j);
+                    else
+                        s.upper = std::max(s.upper, j - i);
+                }
+                for (size_t j = 0; j < i && s.symmetric; ++j)
+                    s.symmetric = r[j] == m[j][i];
+            }
+            return s;
+        },
+        [](TMatrixStructure a, const TMatrixStructure& b) {
+            a.nonZeros += b.nonZeros;
+            a.lower = std::max(a.lower, b.lower);
+            a.upper = std::max(a.upper, b.upper);
+            a.symmetric = a.symmetric && b.symmetric;
+            return a;
+        });
+}
+
+// Структура квадратной CSR-матрицы; симметричность - сравнением с транспонированной
+template<typename Policy, typename T, enable_if_exec_policy_t<Policy> = 0>
+TMatrixStructure AnalyzeStructure(const Policy& policy, const TCSRMatrix<T>& m)
+{
+    if (m.GetRows() != m.GetCols())
+        throw invalid_argument("Matrix should be square");
+
+    TMatrixStructure s;
+    s.size = m.GetRows();
+    s.nonZeros = m.GetNonZeros();
+    const auto& rowPtr = m.RowPtr();
+    const auto& colInd = m.ColIndices();
+    for (size_t i = 0; i < s.size; ++i)
+        for (size_t k = rowPtr[i]; k < rowPtr[i + 1]; ++k)
+        {
+            size_t j = colInd[k];
+            if (j < i)
+                s.lower = std::max(s.lower, i - j);
+            else
+                s.upper = std::max(s.upper, j - i);
+        }
+    s.symmetric = s.lower == s.upper && m == m.Transpose(policy);
+    return s;
+}
+
+// Самое дешёвое по STORAGE_COST_* представление. Диагональная матрица
+// хранится диагональю; CSR и лента берутся, только если занимают меньше
+// памяти, чем плотная матрица; плотная и упакованные - только при
+// size <= MAX_MATRIX_SIZE (иначе остаются CSR и лента).
+template<typename T>
+TMatrixStorage ChooseStorage(const TMatrixStructure& s)
+{
+    if (s.lower == 0 && s.upper == 0)
+        return TMatrixStorage::Diagonal;
+
+    double n = static_cast<double>(s.size);
+    bool denseAllowed = s.size <= MAX_MATRIX_SIZE;
+    double denseBytes = n * n * sizeof(T);
+    double width = static_cast<double>(s.lower + s.upper + 1);
+
+    TMatrixStorage best = TMatrixStorage::Sparse;
+    double bestCost = std::numeric_limits<double>::infinity();
+    auto consider = [&](TMatrixStorage storage, double cost) {
+        if (cost < bestCost)
+        {
+            best = storage;
+            bestCost = cost;
+        }
+    };
+    double csrBytes = static_cast<double>(s.nonZeros) * (sizeof(T) + sizeof(uint32_t)) + (n + 1) * sizeof(size_t);
+    if (!denseAllowed || csrBytes < denseBytes)
+        consider(TMatrixStorage::Sparse, STORAGE_COST_CSR_NONZERO * s.nonZeros + STORAGE_COST_CSR_ROW * n);
+    if (!denseAllowed || width < n)
+        consider(TMatrixStorage::Band, STORAGE_COST_BAND_ELEMENT * n * width + STORAGE_COST_BAND_ROW * n);
+    if (denseAllowed)
+    {
+        consider(TMatrixStorage::Dense, n * n);
+        if (s.lower == 0)
+            consider(TMatrixStorage::UpperTriangular, STORAGE_COST_UPPER_ELEMENT * n * (n + 1) / 2);
+        if (s.symmetric)
+            consider(TMatrixStorage::Symmetric, STORAGE_COST_SYMMETRIC_ELEMENT * n * (n + 1) / 2);
+    }
+    return best;
+}
+
+// Квадратная матрица, которая при создании (и при чтении из потока)
+// измеряет свою структуру (AnalyzeStructure) и хранится в самом дешёвом
+// представлении (ChooseStorage). Операции передаются ядру выбранного
+// представления; у CSR и симметричной нет своего решателя, Solve для них
+// идёт через плотную матрицу. Нижнетреугольные матрицы хранятся лентой,
+// CSR или плотно.
+template<typename T>
+class TAutoMatrix
+{
+public:
+    using TStorage = std::variant<TDynamicMatrix<T>, TCSRMatrix<T>, TBandMatrix<T>,
+                                  TUpperTriangularMatrix<T>, TSymmetricMatrix<T>, TDiagonalMatrix<T>>;
+
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TAutoMatrix(const Policy& policy, const TDynamicMatrix<T>& m)
+        : structure(AnalyzeStructure(policy, m)), data(build(policy, m, structure)) {}
+    explicit TAutoMatrix(const TDynamicMatrix<T>& m) : TAutoMatrix(exec_par, m) {}
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TAutoMatrix(const Policy& policy, const TCSRMatrix<T>& m)
+        : structure(AnalyzeStructure(policy, m)), data(build(policy, m, structure)) {}
+    explicit TAutoMatrix(const TCSRMatrix<T>& m) : TAutoMatrix(exec_par, m) {}
+
+    size_t GetSize() const noexcept { return structure.size; }
+    size_t GetNonZeros() const noexcept { return structure.nonZeros; }
+    const TMatrixStructure& GetStructure() const noexcept { return structure; }
+    TMatrixStorage GetStorage() const noexcept { return static_cast<TMatrixStorage>(data.index()); }
+    // выбранное представление: Get<TBandMatrix<double>>() и т.п.
+    template<typename M>
+    const M& Get() const { return std::get<M>(data); }
+
+    T operator()(size_t i, size_t j) const
+    {
+        return std::visit([i, j](const auto& m) -> T { return m(i, j); }, data);
+    }
+
+    TDynamicMatrix<T> ToDense() const
+    {
+        return std::visit([](const auto& m) -> TDynamicMatrix<T> {
+            if constexpr (std::is_same_v<std::decay_t<decltype(m)>, TDynamicMatrix<T>>)
+                return m;
+            else
+                return m.ToDense();
+        }, data);
+    }
+
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const
+    {
+        return multiply(exec_par, v);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicVector<T> multiply(const Policy& policy, const TDynamicVector<T>& v) const
+    {
+        return std::visit([&](const auto& m) { return m.multiply(policy, v); }, data);
+    }
+
+    // у ленточной и верхнетреугольной нет произведения с плотной матрицей -
+    // оно всё равно O(n^2) по памяти и считается через плотную
+    TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& m) const
+    {
+        return multiply(exec_par, m);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicMatrix<T> multiply(const Policy& policy, const TDynamicMatrix<T>& b) const
+    {
+        return std::visit([&](const auto& m) -> TDynamicMatrix<T> {
+            using M = std::decay_t<decltype(m)>;
+            if constexpr (std::is_same_v<M, TBandMatrix<T>> || std::is_same_v<M, TUpperTriangularMatrix<T>>)
+                return m.ToDense().multiply(policy, b);
+            else
+                return m.multiply(policy, b);
+        }, data);
+    }
+
+    TDynamicVector<T> Solve(const TDynamicVector<T>& b) const
+    {
+        return std::visit([&](const auto& m) -> TDynamicVector<T> {
+            using M = std::decay_t<decltype(m)>;
+            if constexpr (std::is_same_v<M, TCSRMatrix<T>> || std::is_same_v<M, TSymmetricMatrix<T>>)
+                return m.ToDense().Solve(b);
+            else
+                return m.Solve(b);
+        }, data);
+    }
+
+    // чтение плотной матрицы текущего размера с новым выбором представления
+    friend istream& operator>>(istream& istr, TAutoMatrix& a)
+    {
+        TDynamicMatrix<T> m(static_cast<int>(a.GetSize()));
+        istr >> m;
+        if (istr)
+            a = TAutoMatrix(m);
+        return istr;
+    }
+    friend ostream& operator<<(ostream& ostr, const TAutoMatrix& a)
+    {
+        return ostr << a.ToDense();
+    }
+
+private:
+    TMatrixStructure structure;
+    TStorage data;
+
+    template<typename Policy>
+    static TStorage build(const Policy& policy, const TDynamicMatrix<T>& m, const TMatrixStructure& s)
+    {
+        switch (ChooseStorage<T>(s))
+        {
+        case TMatrixStorage::Dense:
+            return m;
+        case TMatrixStorage::Sparse:
+            return TCSRMatrix<T>(policy, m);
+        case TMatrixStorage::Band:
+            return TBandMatrix<T>(m, s.lower, s.upper);
+        case TMatrixStorage::UpperTriangular:
+            return TUpperTriangularMatrix<T>(m);
+        case TMatrixStorage::Symmetric:
+            return TSymmetricMatrix<T>(m);
+        default:
+        {
+            TDiagonalMatrix<T> d(s.size);
+            for (size_t i = 0; i < s.size; ++i)
+                d[i] = m[i][i];
+            return d;
+        }
+        }
+    }
+
+    template<typename Policy>
+    static TStorage build(const Policy& policy, const TCSRMatrix<T>& m, const TMatrixStructure& s)
+    {
+        switch (ChooseStorage<T>(s))
+        {
+        case TMatrixStorage::Dense:
+            return m.ToDense(policy);
+        case TMatrixStorage::Sparse:
+            return m;
+        case TMatrixStorage::Band:
+            return fill(m, TBandMatrix<T>(s.size, s.lower, s.upper), false);
+        case TMatrixStorage::UpperTriangular:
+            return fill(m, TUpperTriangularMatrix<T>(s.size), false);
+        case TMatrixStorage::Symmetric:
+            return fill(m, TSymmetricMatrix<T>(s.size), true);
+        default:
+        {
+            TDiagonalMatrix<T> d(s.size);
+            for (size_t i = 0; i < s.size; ++i)
+                d[i] = m(i, i);
+            return d;
+        }
+        }
+    }
+
+    // перенос ненулевых элементов CSR; у симметричной - только верхний треугольник
+    template<typename M>
+    static M fill(const TCSRMatrix<T>& m, M result, bool upperOnly)
+    {
+        const auto& rowPtr = m.RowPtr();
+        const auto& colInd = m.ColIndices();
+        const auto& values = m.Values();
+        for (size_t i = 0; i < m.GetRows(); ++i)
+            for (size_t k = rowPtr[i]; k < rowPtr[i + 1]; ++k)
+                if (!upperOnly || colInd[k] >= i)
+                    result(i, colInd[k]) = values[k];
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,253 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Ленточные и трёхдиагональные матрицы
+
+#ifndef __TBanded_H__
+#define __TBanded_H__
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "tmatrix.h"
+
+// Ленточная матрица n x n с kl поддиагоналями и ku наддиагоналями -
+// хранится только лента, по строкам: элемент (i, j), i - kl <= j <= i + ku,
+// лежит в band[i * (kl + ku + 1) + j - i + kl]. Память и умножение на
+// вектор - O(n * (kl + ku)); размер не ограничен MAX_MATRIX_SIZE.
+template<typename T>
+class TBandMatrix
+{
+public:
+    TBandMatrix(size_t n, size_t kl, size_t ku) : sz(n), lower(kl), upper(ku)
+    {
+        if (n == 0)
+            throw invalid_argument("Band matrix size should be greater than zero");
+        if (kl >= n || ku >= n)
+            throw invalid_argument("Bandwidth should be less than matrix size");
+        band.resize(n * width());
+    }
+    // лента плотной матрицы; ненулевой элемент вне ленты - ошибка
+    TBandMatrix(const TDynamicMatrix<T>& m, size_t kl, size_t ku) : TBandMatrix(m.GetSize(), kl, ku)
+    {
+        for (size_t i = 0; i < sz; ++i)
+        {
+            const T* r = m[i].data();
+            for (size_t j = 0; j < sz; ++j)
+                if (inBand(i, j))
+                    band[index(i, j)] = r[j];
+                else if (r[j] != T())
+                    throw invalid_argument("Matrix has non-zero elements outside the band");
+        }
+    }
+
+    size_t GetSize() const noexcept { return sz; }
+    size_t GetLower() const noexcept { return lower; }
+    size_t GetUpper() const noexcept { return upper; }
+
+    // элементы ленты; вне ленты доступны только для чтения (нули)
+    T& operator()(size_t i, size_t j)
+    {
+        if (i >= sz || j >= sz)
+            throw out_of_range("Index out of range");
+        if (!inBand(i, j))
+            throw out_of_range("Element is outside the band");
+
+        return band[index(i, j)];
+    }
+    T operator()(size_t i, size_t j) const
+    {
+        if (i >= sz || j >= sz)
+            throw out_of_range("Index out of range");
+
+        return inBand(i, j) ? band[index(i, j)] : T();
+    }
+
+    bool operator==(const TBandMatrix& m) const noexcept
+    {
+        return sz == m.sz && lower == m.lower && upper == m.upper && band == m.band;
+    }
+    bool operator!=(const TBandMatrix& m) const noexcept
+    {
+        return !(*this == m);
+    }
+
+    TDynamicMatrix<T> ToDense() const
+    {
+        if (sz > MAX_MATRIX_SIZE)
+            throw invalid_argument("Matrix size shouldn't be more than MAX_MATRIX_SIZE");
+
+        TDynamicMatrix<T> result(static_cast<int>(sz));
+        for (size_t i = 0; i < sz; ++i)
+        {
+            T* r = result[i].data();
+            for (size_t j = first(i); j <= last(i); ++j)
+                r[j] = band[index(i, j)];
+        }
+        return result;
+    }
+
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const
+    {
+        return multiply(exec_par, v);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicVector<T> multiply(const Policy& policy, const TDynamicVector<T>& v) const
+    {
+        if (v.size() != sz) throw invalid_argument("Matrix columns and vector size must be equal for multiplication!");
+        TDynamicVector<T> result(sz);
+        const T* x = v.data();
+        T* y = result.data();
+        ForEachChunk(policy, sz, std::max<size_t>(1, PARALLEL_MIN_CHUNK / width()), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                // строка ленты и отрезок x идут подряд
+                const T* a = band.data() + index(i, first(i));
+                const T* xj = x + first(i);
+                size_t len = last(i) - first(i) + 1;
+                T s{};
+                for (size_t k = 0; k < len; ++k)
+                    s += a[k] * xj[k];
+                y[i] = s;
+            }
+        });
+        return result;
+    }
+
+    // решение this * x = b через ленточное LU-разложение (см. TBandLU)
+    TDynamicVector<T> Solve(const TDynamicVector<T>& b) const;
+
+private:
+    template<typename> friend class TBandLU;
+
+    size_t sz, lower, upper;
+    std::vector<T> band;
+
+    size_t width() const noexcept { return lower + upper + 1; }
+    size_t first(size_t i) const noexcept { return i > lower ? i - lower : 0; }
+    size_t last(size_t i) const noexcept { return std::min(sz - 1, i + upper); }
+    bool inBand(size_t i, size_t j) const noexcept { return j + lower >= i && j <= i + upper; }
+    size_t index(size_t i, size_t j) const noexcept { return i * width() + j + lower - i; }
+};
+
+// LU-разложение ленточной матрицы с выбором главного элемента по столбцу
+// (как в TDynamicMatrix::Solve). Перестановки строк расширяют U до
+// kl + ku наддиагоналей, поэтому лента хранится шириной 2 * kl + ku + 1;
+// разложение - O(n * kl * (kl + ku)), каждое решение - O(n * (kl + ku)).
+// Разложение можно использовать для многих правых частей.
+template<typename T>
+class TBandLU
+{
+public:
+    explicit TBandLU(const TBandMatrix<T>& m) : sz(m.sz), lower(m.lower), upper(m.lower + m.upper), lu(m.sz * width()), pivots(m.sz)
+    {
+        for (size_t i = 0; i < sz; ++i)
+            for (size_t j = m.first(i); j <= m.last(i); ++j)
+                lu[index(i, j)] = m.band[m.index(i, j)];
+
+        for (size_t k = 0; k < sz; ++k)
+        {
+            size_t rows = std::min(sz - 1, k + lower), cols = std::min(sz - 1, k + upper);
+            size_t p = k;
+            for (size_t i = k + 1; i <= rows; ++i)
+                if (std::abs(lu[index(i, k)]) > std::abs(lu[index(p, k)]))
+                    p = i;
+            if (lu[index(p, k)] == T(0))
+                throw runtime_error("Matrix is singular");
+            pivots[k] = p;
+            if (p != k)
+                for (size_t j = k; j <= cols; ++j)
+                    std::swap(lu[index(k, j)], lu[index(p, j)]);
+
+            const T* rk = lu.data() + index(k, k);
+            for (size_t i = k + 1; i <= rows; ++i)
+            {
+                T* ri = lu.data() + index(i, k);
+                T f = ri[0] / rk[0];
+                ri[0] = f;
+                if (f == T(0))
+                    continue;
+                for (size_t j = 1; j <= cols - k; ++j)
+                    ri[j] -= f * rk[j];
+            }
+        }
+    }
+
+    size_t GetSize() const noexcept { return sz; }
+
+    TDynamicVector<T> Solve(const TDynamicVector<T>& b) const
+    {
+        if (b.size() != sz) throw invalid_argument("Matrix size and right-hand side size must be equal for solving");
+
+        TDynamicVector<T> x(b);
+        T* xs = x.data();
+        for (size_t k = 0; k < sz; ++k)
+        {
+            std::swap(xs[k], xs[pivots[k]]);
+            for (size_t i = k + 1; i <= std::min(sz - 1, k + lower); ++i)
+                xs[i] -= lu[index(i, k)] * xs[k];
+        }
+        for (size_t i = sz; i-- > 0;)
+        {
+            const T* ri = lu.data() + index(i, i);
+            T s = xs[i];
+            for (size_t j = 1; j <= std::min(sz - 1, i + upper) - i; ++j)
+                s -= ri[j] * xs[i + j];
+            xs[i] = s / ri[0];
+        }
+        return x;
+    }
+
+private:
+    size_t sz, lower, upper;   // upper = kl + ku с учётом заполнения
+    std::vector<T> lu;         // L (без единичной диагонали) и U в одной ленте
+    std::vector<size_t> pivots;
+
+    size_t width() const noexcept { return lower + upper + 1; }
+    size_t index(size_t i, size_t j) const noexcept { return i * width() + j + lower - i; }
+};
+
+template<typename T>
+TDynamicVector<T> TBandMatrix<T>::Solve(const TDynamicVector<T>& b) const
+{
+    return TBandLU<T>(*this).Solve(b);
+}
+
+// Решение трёхдиагональной системы методом прогонки (алгоритм Томаса):
+// lower[i] * x[i - 1] + diag[i] * x[i] + upper[i] * x[i + 1] = rhs[i],
+// lower[0] и upper[n - 1] не используются. Без перестановок - устойчиво
+// для матриц с диагональным преобладанием; O(n) времени и памяти
+template<typename T>
+TDynamicVector<T> SolveTridiagonal(const TDynamicVector<T>& lower, const TDynamicVector<T>& diag,
+                                   const TDynamicVector<T>& upper, const TDynamicVector<T>& rhs)
+{
+    size_t n = diag.size();
+    if (lower.size() != n || upper.size() != n || rhs.size() != n)
+        throw invalid_argument("Diagonals and right-hand side should have the same size");
+
+    // прямой ход: c - изменённая наддиагональ, x - изменённая правая часть
+    TDynamicVector<T> c(n), x(rhs);
+    const T* a = lower.data();
+    const T* b = diag.data();
+    const T* u = upper.data();
+    T* cs = c.data();
+    T* xs = x.data();
+    T m = b[0];
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i > 0)
+            m = b[i] - a[i] * cs[i - 1];
+        if (m == T(0))
+            throw runtime_error("Zero pivot in tridiagonal solver");
+        cs[i] = i + 1 < n ? u[i] / m : T();
+        xs[i] = (i > 0 ? xs[i] - a[i] * xs[i - 1] : xs[i]) / m;
+    }
+    // обратный ход
+    for (size_t i = n - 1; i-- > 0;)
+        xs[i] -= cs[i] * xs[i + 1];
+    return x;
+}
+
+#endif
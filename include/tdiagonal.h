@@ -0,0 +1,275 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Диагональная и скалярная (alpha * E) матрицы
+
+#ifndef __TDiagonal_H__
+#define __TDiagonal_H__
+
+#include <algorithm>
+#include "tmatrix.h"
+
+// Диагональная матрица - хранится только диагональ (n элементов).
+// Умножение на вектор - O(n), на плотную матрицу слева/справа -
+// масштабирование строк/столбцов за O(n^2); n^2 памяти выделяется
+// только под результат с плотной матрицей и в ToDense.
+template<typename T>
+class TDiagonalMatrix
+{
+public:
+    TDiagonalMatrix(size_t n = 1) : diag(n) {}
+    explicit TDiagonalMatrix(const TDynamicVector<T>& d) : diag(d) {}
+
+    size_t GetSize() const noexcept { return diag.size(); }
+    const TDynamicVector<T>& Diagonal() const noexcept { return diag; }
+
+    // элементы диагонали
+    T& operator[](size_t i) { return diag[i]; }
+    const T& operator[](size_t i) const { return diag[i]; }
+    // вне диагонали - нули
+    T operator()(size_t i, size_t j) const
+    {
+        if (i >= GetSize() || j >= GetSize())
+            throw out_of_range("Index out of range");
+
+        return i == j ? diag[i] : T();
+    }
+
+    bool operator==(const TDiagonalMatrix& m) const noexcept
+    {
+        return diag == m.diag;
+    }
+    bool operator!=(const TDiagonalMatrix& m) const noexcept
+    {
+        return !(*this == m);
+    }
+
+    TDynamicMatrix<T> ToDense() const
+    {
+        TDynamicMatrix<T> result(static_cast<int>(GetSize()));
+        for (size_t i = 0; i < GetSize(); ++i)
+            result[i][i] = diag[i];
+        return result;
+    }
+
+    TDiagonalMatrix operator+(const TDiagonalMatrix& m) const
+    {
+        return TDiagonalMatrix(diag.add(exec_par, m.diag));
+    }
+    TDiagonalMatrix operator-(const TDiagonalMatrix& m) const
+    {
+        return TDiagonalMatrix(diag.subtract(exec_par, m.diag));
+    }
+    TDiagonalMatrix operator*(const T& val) const
+    {
+        return TDiagonalMatrix(diag.multiply(exec_par, val));
+    }
+    TDiagonalMatrix operator*(const TDiagonalMatrix& m) const
+    {
+        return TDiagonalMatrix(diag.multiplyElementwise(exec_par, m.diag));
+    }
+
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const
+    {
+        return multiply(exec_par, v);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicVector<T> multiply(const Policy& policy, const TDynamicVector<T>& v) const
+    {
+        if (v.size() != GetSize()) throw invalid_argument("Matrix columns and vector size must be equal for multiplication!");
+        return diag.multiplyElementwise(policy, v);
+    }
+
+    // this * m: строка i умножается на d[i]
+    TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& m) const
+    {
+        return multiply(exec_par, m);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicMatrix<T> multiply(const Policy& policy, const TDynamicMatrix<T>& m) const
+    {
+        size_t n = GetSize();
+        if (m.GetSize() != n) throw invalid_argument("Matrix dimensions must match for multiplication!");
+        TDynamicMatrix<T> result(static_cast<int>(n));
+        const T* d = diag.data();
+        ForEachChunk(policy, n, std::max<size_t>(1, PARALLEL_MIN_CHUNK / n), [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                const T* a = m[i].data();
+                T* r = result[i].data();
+                for (size_t j = 0; j < n; ++j)
+                    r[j] = d[i] * a[j];
+            }
+        });
+        return result;
+    }
+
+    // m * this: столбец j умножается на d[j]
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicMatrix<T> multiplyLeft(const Policy& policy, const TDynamicMatrix<T>& m) const
+    {
+        size_t n = GetSize();
+        if (m.GetSize() != n) throw invalid_argument("Matrix dimensions must match for multiplication!");
+        TDynamicMatrix<T> result(static_cast<int>(n));
+        const T* d = diag.data();
+        ForEachChunk(policy, n, std::max<size_t>(1, PARALLEL_MIN_CHUNK / n), [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                const T* a = m[i].data();
+                T* r = result[i].data();
+                for (size_t j = 0; j < n; ++j)
+                    r[j] = a[j] * d[j];
+            }
+        });
+        return result;
+    }
+
+    // решение this * x = b - O(n)
+    TDynamicVector<T> Solve(const TDynamicVector<T>& b) const
+    {
+        if (b.size() != GetSize()) throw invalid_argument("Matrix size and right-hand side size must be equal for solving");
+        TDynamicVector<T> x(b);
+        T* xs = x.data();
+        const T* d = diag.data();
+        for (size_t i = 0; i < GetSize(); ++i)
+        {
+            if (d[i] == T(0))
+                throw runtime_error("Matrix is singular");
+            xs[i] /= d[i];
+        }
+        return x;
+    }
+
+private:
+    TDynamicVector<T> diag;
+};
+
+template<typename T>
+TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& m, const TDiagonalMatrix<T>& d)
+{
+    return d.multiplyLeft(exec_par, m);
+}
+
+// Скалярная матрица alpha * E размера n - хранит только n и alpha:
+// произведения сводятся к умножению на скаляр (O(n) и O(n^2)).
+template<typename T>
+class TScaledIdentity
+{
+public:
+    TScaledIdentity(size_t n = 1, const T& alpha = T(1)) : sz(n), scale(alpha) {}
+
+    size_t GetSize() const noexcept { return sz; }
+    const T& GetScale() const noexcept { return scale; }
+
+    T operator()(size_t i, size_t j) const
+    {
+        if (i >= sz || j >= sz)
+            throw out_of_range("Index out of range");
+
+        return i == j ? scale : T();
+    }
+
+    bool operator==(const TScaledIdentity& m) const noexcept
+    {
+        return sz == m.sz && scale == m.scale;
+    }
+    bool operator!=(const TScaledIdentity& m) const noexcept
+    {
+        return !(*this == m);
+    }
+
+    TDiagonalMatrix<T> ToDiagonal() const
+    {
+        TDynamicVector<T> d(sz);
+        std::fill(d.data(), d.data() + sz, scale);
+        return TDiagonalMatrix<T>(d);
+    }
+    TDynamicMatrix<T> ToDense() const
+    {
+        return ToDiagonal().ToDense();
+    }
+
+    TScaledIdentity operator+(const TScaledIdentity& m) const
+    {
+        if (m.sz != sz) throw invalid_argument("Matrices must be of the same size for addition");
+        return TScaledIdentity(sz, scale + m.scale);
+    }
+    TScaledIdentity operator-(const TScaledIdentity& m) const
+    {
+        if (m.sz != sz) throw invalid_argument("Matrices must be of the same size for subtraction");
+        return TScaledIdentity(sz, scale - m.scale);
+    }
+    TScaledIdentity operator*(const TScaledIdentity& m) const
+    {
+        checkSize(m.sz);
+        return TScaledIdentity(sz, scale * m.scale);
+    }
+    TScaledIdentity operator*(const T& val) const
+    {
+        return TScaledIdentity(sz, scale * val);
+    }
+    TDiagonalMatrix<T> operator*(const TDiagonalMatrix<T>& m) const
+    {
+        checkSize(m.GetSize());
+        return m * scale;
+    }
+
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const
+    {
+        return multiply(exec_par, v);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicVector<T> multiply(const Policy& policy, const TDynamicVector<T>& v) const
+    {
+        if (v.size() != sz) throw invalid_argument("Matrix columns and vector size must be equal for multiplication!");
+        return v.multiply(policy, scale);
+    }
+
+    // alpha * E коммутирует с любой матрицей: this * m = m * this
+    TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& m) const
+    {
+        return multiply(exec_par, m);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicMatrix<T> multiply(const Policy& policy, const TDynamicMatrix<T>& m) const
+    {
+        checkSize(m.GetSize());
+        return m.multiply(policy, scale);
+    }
+
+    TDynamicVector<T> Solve(const TDynamicVector<T>& b) const
+    {
+        if (b.size() != sz) throw invalid_argument("Matrix size and right-hand side size must be equal for solving");
+        if (scale == T(0))
+            throw runtime_error("Matrix is singular");
+        TDynamicVector<T> x(b);
+        T* xs = x.data();
+        for (size_t i = 0; i < sz; ++i)
+            xs[i] /= scale;
+        return x;
+    }
+
+private:
+    size_t sz;
+    T scale;
+
+    void checkSize(size_t n) const
+    {
+        if (n != sz) throw invalid_argument("Matrix dimensions must match for multiplication!");
+    }
+};
+
+template<typename T>
+TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& m, const TScaledIdentity<T>& s)
+{
+    return s.multiply(exec_par, m);
+}
+
+template<typename T>
+TDiagonalMatrix<T> operator*(const TDiagonalMatrix<T>& d, const TScaledIdentity<T>& s)
+{
+    return s * d;
+}
+
+#endif
@@ -7,21 +7,56 @@
 #ifndef __TDynamicMatrix_H__
 #define __TDynamicMatrix_H__
 
+#include <atomic>
+#include <cassert>
+#include <cmath>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "tparallel.h"
 
 using namespace std;
 
 const int MAX_VECTOR_SIZE = 100000000;
 const int MAX_MATRIX_SIZE = 10000;
 
+// a * b + c; для float/double - аппаратная FMA, если она доступна
+// (без неё std::fma вызывается программно и медленнее a * b + c)
+template<typename T>
+inline T MultiplyAdd(const T& a, const T& b, const T& c)
+{
+    return a * b + c;
+}
+#if defined(FP_FAST_FMA) || defined(__FMA__)
+inline double MultiplyAdd(const double& a, const double& b, const double& c)
+{
+    return std::fma(a, b, c);
+}
+#endif
+#if defined(FP_FAST_FMAF) || defined(__FMA__)
+inline float MultiplyAdd(const float& a, const float& b, const float& c)
+{
+    return std::fma(a, b, c);
+}
+#endif
+
 // Динамический вектор - 
-// шаблонный вектор на динамической памяти
+// шаблонный вектор на динамической памяти.
+// По умолчанию копирование глубокое; после SetCopyOnWrite(true) копии
+// разделяют память (O(1), атомарный счётчик ссылок), а собственная копия
+// делается при первом неконстантном доступе (operator[], at, data, apply,
+// ввод). Ссылки и указатели, полученные до копирования, после него
+// для записи использовать нельзя.
 template<typename T>
 class TDynamicVector
 {
 protected:
   size_t sz;
   T* pMem;
+  std::atomic<size_t>* refs = nullptr; // счётчик ссылок в режиме копирования при записи
 public:
     TDynamicVector(size_t size = 1) : sz(size)
     {
@@ -29,38 +64,37 @@ public:
             throw out_of_range("Vector size should be greater than zero");
         if (sz > MAX_VECTOR_SIZE)
             throw out_of_range("Vector size should be less than MAX_VECTOR_SIZE");
-        pMem = new T[sz](); // {} // У типа T д.б. констуктор по умолчанию
+        // У типа T д.б. констуктор по умолчанию
+        pMem = create(sz, [this](T* p) { std::uninitialized_value_construct_n(p, sz); });
     }
   TDynamicVector(T* arr, size_t s) : sz(s)
   {
     assert(arr != nullptr && "TDynamicVector ctor requires non-nullptr arg");
-    pMem = new T[sz];
-    std::copy(arr, arr + sz, pMem);
+    pMem = create(sz, [arr, s](T* p) { std::uninitialized_copy_n(arr, s, p); });
   }
   TDynamicVector(const TDynamicVector& v)
-      : sz(v.sz), pMem(new T[v.sz])
+      : sz(v.sz), pMem(v.pMem), refs(v.refs)
   {
-      std::copy(v.pMem, v.pMem + v.sz, pMem);
+      if (refs != nullptr)
+      {
+          refs->fetch_add(1, std::memory_order_relaxed);
+          return;
+      }
+      pMem = create(v.sz, [&v](T* p) { std::uninitialized_copy_n(v.pMem, v.sz, p); });
   }
-  TDynamicVector(TDynamicVector&& v) : sz(v.sz), pMem(v.pMem)
+  TDynamicVector(TDynamicVector&& v) : sz(v.sz), pMem(v.pMem), refs(v.refs)
   {
       v.sz = 0;
       v.pMem = nullptr;
+      v.refs = nullptr;
   }
   ~TDynamicVector()
   {
-      delete[] pMem;
+      release();
   }
   TDynamicVector multiplyElementwise(const TDynamicVector& v)
   {
-      if (this->sz != v.sz)
-          throw invalid_argument("Vectors should be of the same size for elementwise multiplication");
-
-      TDynamicVector<T> result(this->sz);
-      for (size_t i = 0; i < this->sz; ++i)
-          result[i] = this->pMem[i] * v.pMem[i];
-
-      return result;
+      return multiplyElementwise(exec_seq, v);
   }
   size_t GetSize() const
   {
@@ -70,10 +104,17 @@ public:
   {
       if (this != &v)
       {
-          delete[] pMem;
+          T* p = v.pMem;
+          if (v.refs != nullptr)
+              v.refs->fetch_add(1, std::memory_order_relaxed);
+          else
+          {
+              p = create(v.sz, [&v](T* q) { std::uninitialized_copy_n(v.pMem, v.sz, q); });
+          }
+          release();
           sz = v.sz;
-          pMem = new T[sz];
-          std::copy(v.pMem, v.pMem + sz, pMem);
+          pMem = p;
+          refs = v.refs;
       }
       return *this;
   }
@@ -81,24 +122,53 @@ public:
   {
       if (this != &v)
       {
-          delete[] pMem;
+          release();
           sz = v.sz;
           pMem = v.pMem;
+          refs = v.refs;
           v.sz = 0;
           v.pMem = nullptr;
+          v.refs = nullptr;
       }
 
       return *this;
   }
 
+  // режим копирования при записи (распространяется на копии)
+  void SetCopyOnWrite(bool on)
+  {
+      if (on && refs == nullptr)
+          refs = new std::atomic<size_t>(1);
+      else if (!on && refs != nullptr)
+      {
+          detach();
+          delete refs;
+          refs = nullptr;
+      }
+  }
+  bool IsCopyOnWrite() const noexcept
+  {
+      return refs != nullptr;
+  }
+  // память разделяется с другими копиями
+  bool IsShared() const noexcept
+  {
+      return refs != nullptr && refs->load(std::memory_order_acquire) > 1;
+  }
+
   size_t size() const noexcept { return sz; }
 
+  // непосредственный доступ к памяти (без контроля)
+  T* data() { detach(); return pMem; }
+  const T* data() const noexcept { return pMem; }
+
   // индексация
   T& operator[](size_t ind)
   {
       if (ind >= sz) {
           throw std::out_of_range("Index is out of range!");
       }
+      detach();
       return pMem[ind];
   }
 
@@ -113,6 +183,7 @@ public:
   T& at(size_t ind)
   {
       if (ind >= sz) throw out_of_range("Index out of range");
+      detach();
       return pMem[ind];
   }
   const T& at(size_t ind) const
@@ -140,73 +211,381 @@ public:
   // скалярные операции
   TDynamicVector operator+(T val)
   {
-      TDynamicVector<T> result(this->sz);
-      for (size_t i = 0; i < this->sz; ++i)
-          result[i] = this->pMem[i] + val;
-
-      return result;
+      return add(exec_seq, val);
   }
   TDynamicVector operator-(T val)
   {
-      TDynamicVector<T> result(this->sz);
-      for (size_t i = 0; i < this->sz; ++i)
-          result[i] = this->pMem[i] - val;
-
-      return result;
+      return subtract(exec_seq, val);
   }
   TDynamicVector operator*(T val)
   {
-      TDynamicVector<T> result(this->sz);
-      for (size_t i = 0; i < this->sz; ++i)
-          result[i] = this->pMem[i] * val;
-
-      return result;
+      return multiply(exec_seq, val);
   }
 
   // векторные операции
   TDynamicVector operator+(const TDynamicVector& v)
+  {
+      return add(exec_seq, v);
+  }
+  TDynamicVector operator-(const TDynamicVector& v)
+  {
+      return subtract(exec_seq, v);
+  }
+  T operator*(const TDynamicVector& v)
+  {
+      return dot(exec_seq, v);
+  }
+
+  // операции с политикой выполнения (exec_seq, exec_par, exec_par_unseq,
+  // exec_par_det - редукции побитово воспроизводимы при любом числе потоков)
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector add(const Policy& policy, T val) const
+  {
+      return transformed(policy, [val](const T& a) { return a + val; });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector subtract(const Policy& policy, T val) const
+  {
+      return transformed(policy, [val](const T& a) { return a - val; });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector multiply(const Policy& policy, T val) const
+  {
+      return transformed(policy, [val](const T& a) { return a * val; });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector add(const Policy& policy, const TDynamicVector& v) const
   {
       if (this->sz != v.sz)
           throw invalid_argument("Vectors should be of the same size for addition");
+      return combined(policy, v, [](const T& a, const T& b) { return a + b; });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector subtract(const Policy& policy, const TDynamicVector& v) const
+  {
+      if (this->sz != v.sz)
+          throw invalid_argument("Vectors should be of the same size for subtraction");
+      return combined(policy, v, [](const T& a, const T& b) { return a - b; });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector multiplyElementwise(const Policy& policy, const TDynamicVector& v) const
+  {
+      if (this->sz != v.sz)
+          throw invalid_argument("Vectors should be of the same size for elementwise multiplication");
+      return combined(policy, v, [](const T& a, const T& b) { return a * b; });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  T dot(const Policy& policy, const TDynamicVector& v) const
+  {
+      if (this->sz != v.sz)
+          throw std::invalid_argument("Vectors should be of the same size for dot product!");
 
-      TDynamicVector<T> result(this->sz);
-      for (size_t i = 0; i < this->sz; ++i)
-          result[i] = this->pMem[i] + v.pMem[i];
+      const T* a = pMem;
+      const T* b = v.pMem;
+      return ReduceChunks(policy, sz, PARALLEL_MIN_CHUNK, T{}, [a, b](size_t first, size_t last) {
+          T s{};
+          for (size_t i = first; i < last; ++i)
+              s += a[i] * b[i];
+          return s;
+      });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  T sum(const Policy& policy) const
+  {
+      const T* a = pMem;
+      return ReduceChunks(policy, sz, PARALLEL_MIN_CHUNK, T{}, [a](size_t first, size_t last) {
+          T s{};
+          for (size_t i = first; i < last; ++i)
+              s += a[i];
+          return s;
+      });
+  }
+  // евклидова норма
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  T norm(const Policy& policy) const
+  {
+      return static_cast<T>(std::sqrt(dot(policy, *this)));
+  }
 
+  // слитные поэлементные операции (один проход по памяти)
+  // this * b + c
+  TDynamicVector multiplyAdd(const TDynamicVector& b, const TDynamicVector& c) const
+  {
+      return multiplyAdd(exec_seq, b, c);
+  }
+  // this * val + c
+  TDynamicVector multiplyAdd(T val, const TDynamicVector& c) const
+  {
+      return multiplyAdd(exec_seq, val, c);
+  }
+  // this + t * (b - this)
+  TDynamicVector lerp(const TDynamicVector& b, T t) const
+  {
+      return lerp(exec_seq, b, t);
+  }
+  // ограничение каждого элемента отрезком [lo, hi]
+  TDynamicVector clamp(T lo, T hi) const
+  {
+      return clamp(exec_seq, lo, hi);
+  }
+  // mask[i] ? a[i] : b[i]
+  static TDynamicVector select(const TDynamicVector<bool>& mask, const TDynamicVector& a, const TDynamicVector& b)
+  {
+      return select(exec_seq, mask, a, b);
+  }
+
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector multiplyAdd(const Policy& policy, const TDynamicVector& b, const TDynamicVector& c) const
+  {
+      if (this->sz != b.sz || this->sz != c.sz)
+          throw invalid_argument("Vectors should be of the same size for multiply-add");
+
+      TDynamicVector result(sz);
+      T* r = result.pMem;
+      const T* x = pMem;
+      const T* y = b.pMem;
+      const T* z = c.pMem;
+      ForEachChunk(policy, sz, PARALLEL_MIN_CHUNK, [=](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+              r[i] = MultiplyAdd(x[i], y[i], z[i]);
+      });
       return result;
   }
-  TDynamicVector operator-(const TDynamicVector& v)
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector multiplyAdd(const Policy& policy, T val, const TDynamicVector& c) const
   {
-      if (this->sz != v.sz)
-          throw invalid_argument("Vectors should be of the same size for subtraction");
+      if (this->sz != c.sz)
+          throw invalid_argument("Vectors should be of the same size for multiply-add");
+      return combined(policy, c, [val](const T& a, const T& z) { return MultiplyAdd(a, val, z); });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector lerp(const Policy& policy, const TDynamicVector& b, T t) const
+  {
+      if (this->sz != b.sz)
+          throw invalid_argument("Vectors should be of the same size for interpolation");
+      return combined(policy, b, [t](const T& a, const T& y) { return MultiplyAdd(t, y - a, a); });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector clamp(const Policy& policy, T lo, T hi) const
+  {
+      if (hi < lo)
+          throw invalid_argument("Lower bound should not exceed upper bound");
+      return transformed(policy, [lo, hi](const T& a) { return a < lo ? lo : (hi < a ? hi : a); });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  static TDynamicVector select(const Policy& policy, const TDynamicVector<bool>& mask, const TDynamicVector& a, const TDynamicVector& b)
+  {
+      if (mask.size() != a.sz || a.sz != b.sz)
+          throw invalid_argument("Mask and vectors should be of the same size for selection");
 
-      TDynamicVector<T> result(this->sz);
-      for (size_t i = 0; i < this->sz; ++i)
-          result[i] = this->pMem[i] - v.pMem[i];
+      TDynamicVector result(a.sz);
+      T* r = result.pMem;
+      const bool* m = mask.data();
+      const T* x = a.pMem;
+      const T* y = b.pMem;
+      ForEachChunk(policy, a.sz, PARALLEL_MIN_CHUNK, [=](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+              r[i] = m[i] ? x[i] : y[i];
+      });
+      return result;
+  }
+
+  // пользовательские поэлементные операции: f встраивается в цикл без
+  // контроля индексов, поэтому цикл может быть векторизован компилятором
+  // result[i] = f(this[i])
+  template<typename F>
+  auto map(F f) const
+  {
+      return map(exec_seq, f);
+  }
+  // result[i] = f(this[i], b[i])
+  template<typename U, typename F>
+  auto zipWith(const TDynamicVector<U>& b, F f) const
+  {
+      return zipWith(exec_seq, b, f);
+  }
+  // combine(...combine(init, f(this[0], b[0]))..., f(this[n-1], b[n-1]))
+  template<typename U, typename R, typename C, typename F>
+  R transformReduce(const TDynamicVector<U>& b, R init, C combine, F f) const
+  {
+      return transformReduce(exec_seq, b, init, combine, f);
+  }
+  // this[i] = f(this[i])
+  template<typename F>
+  TDynamicVector& apply(F f)
+  {
+      return apply(exec_seq, f);
+  }
+
+  template<typename Policy, typename F, enable_if_exec_policy_t<Policy> = 0>
+  auto map(const Policy& policy, F f) const
+  {
+      using R = std::decay_t<decltype(f(std::declval<const T&>()))>;
+      TDynamicVector<R> result(sz);
+      R* r = result.data();
+      const T* a = pMem;
+      ForEachChunk(policy, sz, PARALLEL_MIN_CHUNK, [=](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+              r[i] = f(a[i]);
+      });
+      return result;
+  }
+  template<typename Policy, typename U, typename F, enable_if_exec_policy_t<Policy> = 0>
+  auto zipWith(const Policy& policy, const TDynamicVector<U>& b, F f) const
+  {
+      if (this->sz != b.size())
+          throw invalid_argument("Vectors should be of the same size for zipWith");
 
+      using R = std::decay_t<decltype(f(std::declval<const T&>(), std::declval<const U&>()))>;
+      TDynamicVector<R> result(sz);
+      R* r = result.data();
+      const T* x = pMem;
+      const U* y = b.data();
+      ForEachChunk(policy, sz, PARALLEL_MIN_CHUNK, [=](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+              r[i] = f(x[i], y[i]);
+      });
       return result;
   }
-  T operator*(const TDynamicVector& v) noexcept(noexcept(T()))
+  // для параллельных политик combine должна быть ассоциативной
+  template<typename Policy, typename U, typename R, typename C, typename F, enable_if_exec_policy_t<Policy> = 0>
+  R transformReduce(const Policy& policy, const TDynamicVector<U>& b, R init, C combine, F f) const
   {
-      if (this->sz != v.sz)
-          throw std::invalid_argument("Vectors should be of the same size for dot product!");
+      if (this->sz != b.size())
+          throw invalid_argument("Vectors should be of the same size for transformReduce");
 
-      T result{};
-      for (size_t i = 0; i < this->sz; ++i)
-          result += this->pMem[i] * v.pMem[i];
+      const T* x = pMem;
+      const U* y = b.data();
+      return ReduceChunks(policy, sz, PARALLEL_MIN_CHUNK, init, [=](size_t first, size_t last) {
+          R s = f(x[first], y[first]);
+          for (size_t i = first + 1; i < last; ++i)
+              s = combine(s, f(x[i], y[i]));
+          return s;
+      }, combine);
+  }
+  template<typename Policy, typename F, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector& apply(const Policy& policy, F f)
+  {
+      T* a = data();
+      ForEachChunk(policy, sz, PARALLEL_MIN_CHUNK, [=](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+              a[i] = f(a[i]);
+      });
+      return *this;
+  }
+
+  // префиксные суммы (сканирование)
+  // inclusive: result[i] = this[0] + ... + this[i]
+  TDynamicVector inclusiveScan() const
+  {
+      return inclusiveScan(exec_seq);
+  }
+  // exclusive: result[i] = init + this[0] + ... + this[i - 1]
+  TDynamicVector exclusiveScan(T init = T()) const
+  {
+      return exclusiveScan(exec_seq, init);
+  }
+  // сегментированная inclusive: сумма начинается заново там, где heads[i] == true
+  TDynamicVector segmentedInclusiveScan(const TDynamicVector<bool>& heads) const
+  {
+      return segmentedInclusiveScan(exec_seq, heads);
+  }
 
+  // параллельное сканирование в два прохода: суммы кусков, затем
+  // сканирование каждого куска со своим смещением;
+  // out может совпадать с *this (сканирование на месте)
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector inclusiveScan(const Policy& policy) const
+  {
+      TDynamicVector result(sz);
+      scan(policy, result.pMem, T(), true);
+      return result;
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  void inclusiveScan(const Policy& policy, TDynamicVector& out) const
+  {
+      if (out.sz != this->sz)
+          throw invalid_argument("Output vector should be of the same size for scan");
+      scan(policy, out.data(), T(), true);
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector exclusiveScan(const Policy& policy, T init = T()) const
+  {
+      TDynamicVector result(sz);
+      scan(policy, result.pMem, init, false);
+      return result;
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  void exclusiveScan(const Policy& policy, TDynamicVector& out, T init = T()) const
+  {
+      if (out.sz != this->sz)
+          throw invalid_argument("Output vector should be of the same size for scan");
+      scan(policy, out.data(), init, false);
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector segmentedInclusiveScan(const Policy& policy, const TDynamicVector<bool>& heads) const
+  {
+      TDynamicVector result(sz);
+      segmentedInclusiveScan(policy, heads, result);
       return result;
   }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  void segmentedInclusiveScan(const Policy& policy, const TDynamicVector<bool>& heads, TDynamicVector& out) const
+  {
+      if (heads.size() != this->sz || out.sz != this->sz)
+          throw invalid_argument("Heads and output vectors should be of the same size for segmented scan");
+
+      T* r = out.data();
+      const T* a = pMem;
+      const bool* h = heads.data();
+      TChunking chunks = MakeChunking(policy, sz, PARALLEL_MIN_CHUNK);
+      // проход 1: сумма от последнего начала сегмента до конца куска
+      std::vector<T> tails(chunks.count, T());
+      std::vector<char> hasHead(chunks.count, 0);
+      ForEachChunk(policy, chunks.count - 1, 1, [&](size_t first, size_t last) {
+          for (size_t c = first; c < last; ++c)
+          {
+              T s{};
+              for (size_t i = chunks.begin(c); i < chunks.end(c); ++i)
+              {
+                  if (h[i])
+                  {
+                      s = T();
+                      hasHead[c] = 1;
+                  }
+                  s += a[i];
+              }
+              tails[c] = s;
+          }
+      });
+      std::vector<T> carry(chunks.count, T());
+      for (size_t c = 1; c < chunks.count; ++c)
+          carry[c] = hasHead[c - 1] ? tails[c - 1] : carry[c - 1] + tails[c - 1];
+      // проход 2
+      ForEachChunk(policy, chunks.count, 1, [&](size_t first, size_t last) {
+          for (size_t c = first; c < last; ++c)
+          {
+              T s = carry[c];
+              for (size_t i = chunks.begin(c); i < chunks.end(c); ++i)
+              {
+                  s = h[i] ? a[i] : s + a[i];
+                  r[i] = s;
+              }
+          }
+      });
+  }
 
   friend void swap(TDynamicVector& lhs, TDynamicVector& rhs) noexcept
   {
     std::swap(lhs.sz, rhs.sz);
     std::swap(lhs.pMem, rhs.pMem);
+    std::swap(lhs.refs, rhs.refs);
   }
 
   // ввод/вывод
   friend istream& operator>>(istream& istr, TDynamicVector& v)
   {
+    v.detach();
     for (size_t i = 0; i < v.sz; i++)
       istr >> v.pMem[i]; // требуется оператор>> для типа T
     return istr;
@@ -217,6 +596,110 @@ public:
       ostr << v.pMem[i] << ' '; // требуется оператор<< для типа T
     return ostr;
   }
+
+protected:
+  // собственная копия разделяемой памяти перед записью
+  void detach()
+  {
+      if (refs == nullptr || refs->load(std::memory_order_acquire) == 1)
+          return;
+      std::atomic<size_t>* r = new std::atomic<size_t>(1);
+      T* p;
+      try
+      {
+          p = create(sz, [this](T* q) { std::uninitialized_copy_n(pMem, sz, q); });
+      }
+      catch (...)
+      {
+          delete r;
+          throw;
+      }
+      release();
+      pMem = p;
+      refs = r;
+  }
+  void release() noexcept
+  {
+      if (refs == nullptr)
+          destroy(pMem, sz);
+      else if (refs->fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+          destroy(pMem, sz);
+          delete refs;
+      }
+  }
+  // память под n элементов, объекты в ней создаёт init(p); память и объекты
+  // разделены, чтобы массив строк матрицы можно было создать пустым
+  template<typename Init>
+  static T* create(size_t n, Init init)
+  {
+      T* p = std::allocator<T>().allocate(n);
+      try
+      {
+          init(p);
+      }
+      catch (...)
+      {
+          std::allocator<T>().deallocate(p, n);
+          throw;
+      }
+      return p;
+  }
+  static void destroy(T* p, size_t n) noexcept
+  {
+      if (p == nullptr)
+          return;
+      std::destroy_n(p, n);
+      std::allocator<T>().deallocate(p, n);
+  }
+
+private:
+  template<typename> friend class TDynamicMatrix;
+
+  // память без обнуления - для результатов, которые сразу заполняются целиком
+  struct TUninitialized {};
+  TDynamicVector(size_t size, TUninitialized) : sz(size)
+  {
+      pMem = create(sz, [this](T* p) { std::uninitialized_default_construct_n(p, sz); });
+  }
+  // пустой вектор без памяти (как после перемещения) - строка матрицы,
+  // которую затем заполняет операция
+  struct TEmpty {};
+  TDynamicVector(TEmpty) noexcept : sz(0), pMem(nullptr) {}
+
+  // сканирование в r (r может совпадать с pMem)
+  template<typename Policy>
+  void scan(const Policy& policy, T* r, T init, bool inclusive) const
+  {
+      ScanChunks(policy, pMem, r, sz, init, inclusive);
+  }
+  // result[i] = f(pMem[i])
+  template<typename Policy, typename F>
+  TDynamicVector transformed(const Policy& policy, F f) const
+  {
+      TDynamicVector result(sz);
+      T* r = result.pMem;
+      const T* a = pMem;
+      ForEachChunk(policy, sz, PARALLEL_MIN_CHUNK, [=](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+              r[i] = f(a[i]);
+      });
+      return result;
+  }
+  // result[i] = f(pMem[i], v.pMem[i])
+  template<typename Policy, typename F>
+  TDynamicVector combined(const Policy& policy, const TDynamicVector& v, F f) const
+  {
+      TDynamicVector result(sz);
+      T* r = result.pMem;
+      const T* a = pMem;
+      const T* b = v.pMem;
+      ForEachChunk(policy, sz, PARALLEL_MIN_CHUNK, [=](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+              r[i] = f(a[i], b[i]);
+      });
+      return result;
+  }
 };
 
 
@@ -228,7 +711,11 @@ class TDynamicMatrix : private TDynamicVector<TDynamicVector<T>>
   using TDynamicVector<TDynamicVector<T>>::pMem;
   using TDynamicVector<TDynamicVector<T>>::sz;
 public:
-    TDynamicMatrix(int s)
+    // placement - размещение строк по узлам NUMA (см. TMemoryPlacement):
+    // строки выделяются и обнуляются теми потоками пула, которые затем
+    // обрабатывают их в параллельных операциях
+    TDynamicMatrix(int s, TMemoryPlacement placement = TThreadPool::GetPlacement())
+        : TDynamicVector<TDynamicVector<T>>(typename TDynamicVector<TDynamicVector<T>>::TEmpty{})
     {
         if (s < 0) {
             throw std::invalid_argument("Matrix size shouldn't be less than zero");
@@ -236,19 +723,38 @@ public:
         if (s > MAX_MATRIX_SIZE) {
             throw std::invalid_argument("Matrix size shouldn't be more than MAX_MATRIX_SIZE");
         }
-        sz = static_cast<size_t>(s);
-        std::unique_ptr<TDynamicVector<T>[]> tempMem = std::make_unique<TDynamicVector<T>[]>(sz);
-        for (size_t i = 0; i < sz; i++)
-            tempMem[i] = TDynamicVector<T>(sz);
-
-        pMem = tempMem.get();
-        tempMem.release();
+        size_t n = static_cast<size_t>(s);
+        // при исключении уже созданные строки освобождает деструктор базового класса
+        createEmptyRows(n);
+        TDynamicVector<T>* rows = pMem;
+        if (placement == TMemoryPlacement::Local && n * n >= PARALLEL_MIN_CHUNK)
+        {
+            ParallelForStatic(n, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i++)
+                    rows[i] = TDynamicVector<T>(n);
+            });
+        }
+        else if (placement == TMemoryPlacement::Interleave && n * n >= PARALLEL_MIN_CHUNK)
+        {
+            size_t threads = TThreadPool::Instance().GetWorkerCount() + 1;
+            ParallelForStatic(threads, [&](size_t first, size_t last) {
+                for (size_t w = first; w < last; w++)
+                    for (size_t i = w; i < n; i += threads)
+                        rows[i] = TDynamicVector<T>(n);
+            });
+        }
+        else
+        {
+            for (size_t i = 0; i < n; i++)
+                rows[i] = TDynamicVector<T>(n);
+        }
     }
   T& operator()(size_t i, size_t j)
   {
       if (i >= sz || j >= pMem[i].GetSize())
           throw std::out_of_range("Index out of range");
 
+      this->detach();
       return pMem[i][j];
   }
   const T& operator()(size_t i, size_t j) const
@@ -274,6 +780,23 @@ public:
   {
       return sz;
   }
+  // копирование при записи для массива строк и для самих строк:
+  // копия матрицы - O(1), при записи копируются только затронутые строки
+  void SetCopyOnWrite(bool on)
+  {
+      this->detach();
+      for (size_t i = 0; i < sz; ++i)
+          pMem[i].SetCopyOnWrite(on);
+      TDynamicVector<TDynamicVector<T>>::SetCopyOnWrite(on);
+  }
+  bool IsCopyOnWrite() const noexcept
+  {
+      return TDynamicVector<TDynamicVector<T>>::IsCopyOnWrite();
+  }
+  bool IsShared() const noexcept
+  {
+      return TDynamicVector<TDynamicVector<T>>::IsShared();
+  }
   // сравнение
   bool operator==(const TDynamicMatrix& m) const noexcept
   {
@@ -302,10 +825,7 @@ public:
   // матрично-скалярные операции
   TDynamicMatrix operator*(const T& val)
   {
-      TDynamicMatrix<T> result(this->sz);
-      for (size_t i = 0; i < this->sz; ++i)
-          result[i] = (*this)[i] * val;
-      return result;
+      return multiply(exec_par, val);
   }
 
   // матрично-векторные операции
@@ -322,30 +842,223 @@ public:
   // матрично-матричные операции
   TDynamicMatrix operator+(const TDynamicMatrix& m)
   {
-      if (m.sz != this->sz) throw invalid_argument("Matrices must be of the same size for addition");
-      TDynamicMatrix<T> result(this->sz);
-      for (size_t i = 0; i < this->sz; ++i)
-          result[i] = (*this)[i] + m[i];
-      return result;
+      return add(exec_par, m);
   }
   TDynamicMatrix operator-(const TDynamicMatrix& m)
+  {
+      return subtract(exec_par, m);
+  }
+  TDynamicMatrix operator*(const TDynamicMatrix& m)
+  {
+      return multiply(exec_seq, m);
+  }
+
+  // решение системы this * x = b методом Гаусса с выбором главного элемента
+  // (для вещественных типов T)
+  TDynamicVector<T> Solve(const TDynamicVector<T>& b) const
+  {
+      return Solve(exec_seq, b);
+  }
+  // строки исключаются параллельно на каждом шаге
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector<T> Solve(const Policy& policy, const TDynamicVector<T>& b) const
+  {
+      return solve(policy, b, nullptr);
+  }
+  // с отменой, крайним сроком и ходом выполнения по шагам исключения
+  // (TOperationCancelled или TDeadlineExceeded между шагами)
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector<T> Solve(const Policy& policy, const TDynamicVector<T>& b, const TOperationControl& control) const
+  {
+      return solve(policy, b, &control);
+  }
+
+  // операции с политикой выполнения (распараллеливание по строкам);
+  // поэлементные операции делятся на блоки строк не меньше grain элементов
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicMatrix add(const Policy& policy, const TDynamicMatrix& m, size_t grain = PARALLEL_MIN_CHUNK) const
+  {
+      if (m.sz != this->sz) throw invalid_argument("Matrices must be of the same size for addition");
+      return rowwise(policy, grain, [&m](size_t i, const T* a, T* r, size_t n) {
+          const T* b = m.row(i).data();
+          for (size_t j = 0; j < n; ++j)
+              r[j] = a[j] + b[j];
+      });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicMatrix subtract(const Policy& policy, const TDynamicMatrix& m, size_t grain = PARALLEL_MIN_CHUNK) const
   {
       if (m.sz != this->sz) throw invalid_argument("Matrices must be of the same size for subtraction");
-      TDynamicMatrix<T> result(this->sz);
-      for (size_t i = 0; i < this->sz; ++i)
-          result[i] = (*this)[i] - m[i];
+      return rowwise(policy, grain, [&m](size_t i, const T* a, T* r, size_t n) {
+          const T* b = m.row(i).data();
+          for (size_t j = 0; j < n; ++j)
+              r[j] = a[j] - b[j];
+      });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicMatrix multiply(const Policy& policy, const T& val, size_t grain = PARALLEL_MIN_CHUNK) const
+  {
+      return rowwise(policy, grain, [val](size_t, const T* a, T* r, size_t n) {
+          for (size_t j = 0; j < n; ++j)
+              r[j] = a[j] * val;
+      });
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicVector<T> multiply(const Policy& policy, const TDynamicVector<T>& v) const
+  {
+      if (v.size() != this->sz) throw invalid_argument("Matrix columns and vector size must be equal for multiplication!");
+      TDynamicVector<T> result(this->sz);
+      T* r = result.data();
+      ForEachChunk(policy, sz, rowGrain(), [&](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+              r[i] = pMem[i].dot(exec_seq, v);
+      });
       return result;
   }
-  TDynamicMatrix operator*(const TDynamicMatrix& m)
+  // порядок i-k-j: внутренний цикл идёт по строкам this-результата и m подряд;
+  // каждый элемент результата суммируется в одном и том же порядке по k,
+  // поэтому произведение не зависит ни от политики, ни от числа потоков
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicMatrix multiply(const Policy& policy, const TDynamicMatrix& m) const
   {
-      if (m.sz != this->sz) throw invalid_argument("Matrix dimensions must match for multiplication!");
-      TDynamicMatrix<T> result(this->sz);
-      for (size_t i = 0; i < this->sz; ++i)
-          for (size_t j = 0; j < m.sz; ++j)
-              for (size_t k = 0; k < this->sz; ++k)
-                  result[i][j] += (*this)[i][k] * m[k][j];
+      return product(policy, m, nullptr);
+  }
+  // с отменой, крайним сроком и ходом выполнения по строкам результата
+  // (проверка перед каждой строкой)
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicMatrix multiply(const Policy& policy, const TDynamicMatrix& m, const TOperationControl& control) const
+  {
+      return product(policy, m, &control);
+  }
+  // строки [rowFirst, rowLast) и столбцы [colFirst, colLast) произведения a * b,
+  // прибавляемые к c. Разделяемая память c (см. SetCopyOnWrite) отделяется
+  // здесь; перед параллельными вызовами для одной c её массив строк и сами
+  // строки отделяет вызывающий, и тогда здесь ничего не копируется
+  static void MultiplyRows(const TDynamicMatrix& a, const TDynamicMatrix& b, TDynamicMatrix& c,
+                           size_t rowFirst, size_t rowLast, size_t colFirst, size_t colLast)
+  {
+      c.detach();
+      size_t n = a.sz;
+      for (size_t i = rowFirst; i < rowLast; ++i)
+      {
+          const T* ai = a.row(i).data();
+          T* ci = c.pMem[i].data();
+          for (size_t k = 0; k < n; ++k)
+          {
+              const T aik = ai[k];
+              const T* bk = b.row(k).data();
+              for (size_t j = colFirst; j < colLast; ++j)
+                  ci[j] += aik * bk[j];
+          }
+      }
+  }
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  T sum(const Policy& policy) const
+  {
+      return ReduceChunks(policy, sz, rowGrain(), T{}, [this](size_t first, size_t last) {
+          T s{};
+          for (size_t i = first; i < last; ++i)
+              s += pMem[i].sum(exec_seq);
+          return s;
+      });
+  }
+  // норма Фробениуса
+  template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+  T norm(const Policy& policy) const
+  {
+      T squares = ReduceChunks(policy, sz, rowGrain(), T{}, [this](size_t first, size_t last) {
+          T s{};
+          for (size_t i = first; i < last; ++i)
+              s += pMem[i].dot(exec_seq, pMem[i]);
+          return s;
+      });
+      return static_cast<T>(std::sqrt(squares));
+  }
+
+  // пользовательские поэлементные операции (см. TDynamicVector::map и др.)
+  template<typename F>
+  auto map(F f) const
+  {
+      return map(exec_seq, f);
+  }
+  template<typename U, typename F>
+  auto zipWith(const TDynamicMatrix<U>& m, F f) const
+  {
+      return zipWith(exec_seq, m, f);
+  }
+  template<typename U, typename R, typename C, typename F>
+  R transformReduce(const TDynamicMatrix<U>& m, R init, C combine, F f) const
+  {
+      return transformReduce(exec_seq, m, init, combine, f);
+  }
+  template<typename F>
+  TDynamicMatrix& apply(F f)
+  {
+      return apply(exec_seq, f);
+  }
+
+  template<typename Policy, typename F, enable_if_exec_policy_t<Policy> = 0>
+  auto map(const Policy& policy, F f) const
+  {
+      using R = std::decay_t<decltype(f(std::declval<const T&>()))>;
+      TDynamicMatrix<R> result(static_cast<int>(sz));
+      ForEachChunk(policy, sz, rowGrain(), [&](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+          {
+              const T* a = row(i).data();
+              R* r = result[i].data();
+              for (size_t j = 0, n = pMem[i].size(); j < n; ++j)
+                  r[j] = f(a[j]);
+          }
+      });
+      return result;
+  }
+  template<typename Policy, typename U, typename F, enable_if_exec_policy_t<Policy> = 0>
+  auto zipWith(const Policy& policy, const TDynamicMatrix<U>& m, F f) const
+  {
+      if (m.GetSize() != this->sz) throw invalid_argument("Matrices must be of the same size for zipWith");
+
+      using R = std::decay_t<decltype(f(std::declval<const T&>(), std::declval<const U&>()))>;
+      TDynamicMatrix<R> result(static_cast<int>(sz));
+      ForEachChunk(policy, sz, rowGrain(), [&](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+          {
+              const T* a = row(i).data();
+              const U* b = m[i].data();
+              R* r = result[i].data();
+              for (size_t j = 0, n = pMem[i].size(); j < n; ++j)
+                  r[j] = f(a[j], b[j]);
+          }
+      });
       return result;
   }
+  template<typename Policy, typename U, typename R, typename C, typename F, enable_if_exec_policy_t<Policy> = 0>
+  R transformReduce(const Policy& policy, const TDynamicMatrix<U>& m, R init, C combine, F f) const
+  {
+      if (m.GetSize() != this->sz) throw invalid_argument("Matrices must be of the same size for transformReduce");
+
+      return ReduceChunks(policy, sz, rowGrain(), init, [&](size_t first, size_t last) {
+          R s = f(row(first).data()[0], m[first].data()[0]);
+          for (size_t i = first; i < last; ++i)
+          {
+              const T* a = row(i).data();
+              const U* b = m[i].data();
+              for (size_t j = (i == first ? 1 : 0), n = pMem[i].size(); j < n; ++j)
+                  s = combine(s, f(a[j], b[j]));
+          }
+          return s;
+      }, combine);
+  }
+  template<typename Policy, typename F, enable_if_exec_policy_t<Policy> = 0>
+  TDynamicMatrix& apply(const Policy& policy, F f)
+  {
+      this->detach();
+      ForEachChunk(policy, sz, rowGrain(), [&](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+              pMem[i].apply(exec_seq, f);
+      });
+      return *this;
+  }
 
   // ввод/вывод
   friend istream& operator>>(istream& istr, TDynamicMatrix& v)
@@ -360,5 +1073,126 @@ public:
           ostr << v[i] << "\n";
       return ostr;
   }
+
+private:
+  // строка только для чтения: неконстантный доступ к строке
+  // в режиме копирования при записи отделяет её от копий
+  const TDynamicVector<T>& row(size_t i) const noexcept
+  {
+      return pMem[i];
+  }
+  static T magnitude(const T& v)
+  {
+      return v < T(0) ? -v : v;
+  }
+  template<typename Policy>
+  TDynamicMatrix product(const Policy& policy, const TDynamicMatrix& m, const TOperationControl* control) const
+  {
+      if (m.sz != this->sz) throw invalid_argument("Matrix dimensions must match for multiplication!");
+      TDynamicMatrix result(static_cast<int>(sz));
+      TOperationProgress progress(control, sz);
+      ForEachChunk(policy, sz, std::max<size_t>(1, rowGrain() / (sz + 1)), [&](size_t first, size_t last) {
+          if (control == nullptr)
+          {
+              MultiplyRows(*this, m, result, first, last, 0, sz);
+              return;
+          }
+          for (size_t i = first; i < last; ++i)
+          {
+              progress.Check();
+              MultiplyRows(*this, m, result, i, i + 1, 0, sz);
+              progress.Advance();
+          }
+      });
+      return result;
+  }
+  template<typename Policy>
+  TDynamicVector<T> solve(const Policy& policy, const TDynamicVector<T>& b, const TOperationControl* control) const
+  {
+      if (b.size() != this->sz) throw invalid_argument("Matrix size and right-hand side size must be equal for solving");
+
+      TDynamicMatrix a(*this);
+      a.SetCopyOnWrite(false); // строки a изменяются на месте
+      TDynamicVector<T> x(b);
+      T* xs = x.data();
+      TOperationProgress progress(control, sz);
+      for (size_t k = 0; k < sz; ++k)
+      {
+          progress.Check();
+          size_t p = k;
+          for (size_t i = k + 1; i < sz; ++i)
+              if (magnitude(a.pMem[i].data()[k]) > magnitude(a.pMem[p].data()[k]))
+                  p = i;
+          if (a.pMem[p].data()[k] == T(0))
+              throw runtime_error("Matrix is singular");
+          swap(a.pMem[k], a.pMem[p]);
+          std::swap(xs[k], xs[p]);
+
+          const T* rk = a.pMem[k].data();
+          size_t rows = sz - k - 1;
+          ForEachChunk(policy, rows, std::max<size_t>(1, PARALLEL_MIN_CHUNK / (rows + 1)), [&](size_t first, size_t last) {
+              for (size_t i = k + 1 + first; i < k + 1 + last; ++i)
+              {
+                  T* ri = a.pMem[i].data();
+                  T f = ri[k] / rk[k];
+                  if (f == T(0))
+                      continue;
+                  for (size_t j = k; j < sz; ++j)
+                      ri[j] -= f * rk[j];
+                  xs[i] -= f * xs[k];
+              }
+          });
+          progress.Advance();
+      }
+      for (size_t i = sz; i-- > 0;)
+      {
+          const T* ri = a.pMem[i].data();
+          T s = xs[i];
+          for (size_t j = i + 1; j < sz; ++j)
+              s -= ri[j] * xs[j];
+          xs[i] = s / ri[i];
+      }
+      return x;
+  }
+
+  // число строк в блоке из grain элементов
+  size_t rowGrain(size_t grain = PARALLEL_MIN_CHUNK) const noexcept
+  {
+      return sz == 0 ? 1 : std::max<size_t>(1, grain / sz);
+  }
+
+  // матрица с незаполненными строками (их создаёт заполняющая операция)
+  struct TNoRows {};
+  TDynamicMatrix(size_t n, TNoRows) : TDynamicVector<TDynamicVector<T>>(typename TDynamicVector<TDynamicVector<T>>::TEmpty{})
+  {
+      createEmptyRows(n);
+  }
+  // массив из n пустых строк вместо пустого массива базового класса
+  void createEmptyRows(size_t n)
+  {
+      using TRow = TDynamicVector<T>;
+      pMem = TDynamicVector<TRow>::create(n, [n](TRow* p) {
+          for (size_t i = 0; i < n; ++i)
+              new (p + i) TRow(typename TRow::TEmpty{});
+      });
+      sz = n;
+  }
+
+  // f(i, строка i исходной матрицы, строка i результата, длина строки);
+  // строки результата создаются в тех же задачах, что и заполняются,
+  // поэтому выделение памяти тоже идёт параллельно и без лишнего прохода
+  template<typename Policy, typename F>
+  TDynamicMatrix rowwise(const Policy& policy, size_t grain, F f) const
+  {
+      TDynamicMatrix result(sz, TNoRows{});
+      ForEachChunk(policy, sz, rowGrain(grain), [&](size_t first, size_t last) {
+          for (size_t i = first; i < last; ++i)
+          {
+              result.pMem[i] = TDynamicVector<T>(sz, typename TDynamicVector<T>::TUninitialized{});
+              f(i, row(i).data(), result.pMem[i].data(), sz);
+          }
+      });
+      return result;
+  }
 };
 #endif
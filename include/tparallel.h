@@ -0,0 +1,819 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Политики выполнения, пул потоков и параллельный обход диапазонов
+
+#ifndef __TParallel_H__
+#define __TParallel_H__
+
+#if !defined(__cpp_inline_variables) || !defined(__cpp_if_constexpr)
+#error "tparallel.h requires C++17"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// минимальное число элементов на один кусок
+const size_t PARALLEL_MIN_CHUNK = 32768;
+// кусков на поток: запас для балансировки кражей задач
+const size_t PARALLEL_CHUNKS_PER_THREAD = 4;
+
+// Политики выполнения -
+// аналог std::execution, не требующий TBB
+struct TSequencedPolicy {};
+struct TParallelPolicy {};
+struct TParallelUnsequencedPolicy {};
+// детерминированная параллельная политика: разбиение на куски зависит
+// только от размера задачи, частичные результаты редукций объединяются
+// фиксированным попарным деревом - результат побитово одинаков
+// при любом числе потоков
+struct TDeterministicPolicy {};
+
+constexpr TSequencedPolicy exec_seq{};
+constexpr TParallelPolicy exec_par{};
+constexpr TParallelUnsequencedPolicy exec_par_unseq{};
+constexpr TDeterministicPolicy exec_par_det{};
+
+template<typename P>
+struct is_exec_policy : std::false_type {};
+template<> struct is_exec_policy<TSequencedPolicy> : std::true_type {};
+template<> struct is_exec_policy<TParallelPolicy> : std::true_type {};
+template<> struct is_exec_policy<TParallelUnsequencedPolicy> : std::true_type {};
+template<> struct is_exec_policy<TDeterministicPolicy> : std::true_type {};
+
+template<typename P>
+constexpr bool is_exec_policy_v = is_exec_policy<std::decay_t<P>>::value;
+
+template<typename P>
+using enable_if_exec_policy_t = std::enable_if_t<is_exec_policy_v<P>, int>;
+
+// Размещение памяти матриц на NUMA-системах (по правилу первого касания):
+//   Default    - память выделяет и обнуляет создающий поток;
+//   Local      - блок строк выделяет тот поток пула, который затем
+//                обрабатывает его в параллельных операциях;
+//   Interleave - строки выделяются потоками по кругу, память
+//                равномерно распределяется по узлам.
+// При Local и Interleave параллельные операции используют статическое
+// разбиение: кусок c всегда выполняется c-м потоком пула.
+enum class TMemoryPlacement { Default, Local, Interleave };
+
+// Пул потоков с кражей задач (work stealing) -
+// общий для всех параллельных операций библиотеки.
+// Запускается при первом обращении; число потоков задаётся
+// SetConcurrency или переменной окружения TMATRIX_NUM_THREADS
+// (по умолчанию - число аппаратных потоков). Поток, ожидающий
+// завершения своих задач, сам выполняет задачи из очередей, поэтому
+// вложенный параллелизм не создаёт лишних потоков и не блокирует пул.
+class TThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    static TThreadPool& Instance()
+    {
+        static TThreadPool pool;
+        std::call_once(pool.started, [] { pool.start(GetConcurrency()); });
+        return pool;
+    }
+
+    // число потоков, включая вызывающий
+    static size_t GetConcurrency()
+    {
+        size_t n = configured().load();
+        if (n != 0)
+            return n;
+        if (const char* env = std::getenv("TMATRIX_NUM_THREADS"))
+        {
+            long v = std::strtol(env, nullptr, 10);
+            if (v > 0)
+                return static_cast<size_t>(v);
+        }
+        return std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    // перезапускает пул: вызывать, только когда пул простаивает
+    // (не из задач пула и не во время параллельных операций в других потоках);
+    // задачи, оставшиеся в очередях, выполняет вызывающий поток
+    static void SetConcurrency(size_t n)
+    {
+        if (n == 0)
+            throw std::invalid_argument("Thread pool concurrency should be greater than zero");
+        TThreadPool& pool = Instance();
+        pool.checkOutsideTask();
+        configured() = n;
+        pool.restart();
+    }
+
+    // привязка рабочих потоков к процессорам (поток i - к процессору i + 1,
+    // процессор 0 остаётся вызывающему потоку); переменная окружения
+    // TMATRIX_PIN_THREADS=1; поддерживается только в Linux.
+    // SetPinThreads перезапускает пул - те же ограничения, что у SetConcurrency
+    static bool GetPinThreads()
+    {
+        int v = pinConfigured().load();
+        if (v >= 0)
+            return v != 0;
+        const char* env = std::getenv("TMATRIX_PIN_THREADS");
+        return env != nullptr && std::strtol(env, nullptr, 10) != 0;
+    }
+    static void SetPinThreads(bool pin)
+    {
+        TThreadPool& pool = Instance();
+        pool.checkOutsideTask();
+        pinConfigured() = pin ? 1 : 0;
+        pool.restart();
+    }
+
+    // переменная окружения TMATRIX_PLACEMENT=local|interleave
+    static TMemoryPlacement GetPlacement()
+    {
+        int v = placementConfigured().load();
+        if (v >= 0)
+            return static_cast<TMemoryPlacement>(v);
+        if (const char* env = std::getenv("TMATRIX_PLACEMENT"))
+        {
+            std::string value(env);
+            if (value == "local")
+                return TMemoryPlacement::Local;
+            if (value == "interleave")
+                return TMemoryPlacement::Interleave;
+        }
+        return TMemoryPlacement::Default;
+    }
+    static void SetPlacement(TMemoryPlacement placement)
+    {
+        placementConfigured() = static_cast<int>(placement);
+    }
+
+    // число рабочих потоков (без вызывающего)
+    size_t GetWorkerCount() const noexcept
+    {
+        return workers.size();
+    }
+
+    // задача из потока пула попадает в его очередь, иначе - в общую
+    void Submit(Task task)
+    {
+        size_t q = currentPool == this ? currentIndex : queues.size() - 1;
+        {
+            std::lock_guard<std::mutex> lock(queues[q]->mutex);
+            queues[q]->tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_one();
+    }
+
+    // задача, которую выполнит только рабочий поток worker
+    void SubmitTo(size_t worker, Task task)
+    {
+        if (worker >= workers.size())
+            throw std::out_of_range("Worker index is out of range");
+        {
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+            queues[worker]->pinned.push_back(std::move(task));
+            queues[worker]->pinnedCount.fetch_add(1);
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_all();
+    }
+
+    // выполнить одну задачу: закреплённую за потоком, свою последнюю,
+    // общую или украденную первую
+    bool TryRunOne()
+    {
+        Task task;
+        if (!take(task))
+            return false;
+        task();
+        return true;
+    }
+
+    TThreadPool(const TThreadPool&) = delete;
+    TThreadPool& operator=(const TThreadPool&) = delete;
+    ~TThreadPool()
+    {
+        stop();
+    }
+
+private:
+    struct TQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::deque<Task> pinned;
+        std::atomic<size_t> pinnedCount{ 0 };
+    };
+
+    // очереди рабочих потоков и последней - общая
+    std::vector<std::unique_ptr<TQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{ 0 };
+    std::atomic<bool> stopping{ false };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::once_flag started;
+
+    inline static thread_local TThreadPool* currentPool = nullptr;
+    inline static thread_local size_t currentIndex = 0;
+
+    TThreadPool() = default;
+
+    static std::atomic<size_t>& configured()
+    {
+        static std::atomic<size_t> n{ 0 };
+        return n;
+    }
+    static std::atomic<int>& pinConfigured()
+    {
+        static std::atomic<int> v{ -1 };
+        return v;
+    }
+    static std::atomic<int>& placementConfigured()
+    {
+        static std::atomic<int> v{ -1 };
+        return v;
+    }
+
+    void checkOutsideTask() const
+    {
+        if (currentPool == this)
+            throw std::logic_error("Thread pool can't be restarted from its own task");
+    }
+    void restart()
+    {
+        stop();
+        drain();
+        start(GetConcurrency());
+    }
+
+    void start(size_t concurrency)
+    {
+        stopping = false;
+        size_t n = concurrency - 1;
+        bool pin = GetPinThreads();
+        queues.clear();
+        for (size_t i = 0; i <= n; ++i)
+            queues.push_back(std::make_unique<TQueue>());
+        for (size_t i = 0; i < n; ++i)
+            workers.emplace_back([this, i, pin] {
+                if (pin)
+                    pinToCpu(i + 1);
+                workerLoop(i);
+            });
+    }
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers)
+            w.join();
+        workers.clear();
+    }
+    // выполнить задачи, которые не успели взять остановленные потоки
+    // (в том числе закреплённые и поставленные во время выполнения)
+    void drain()
+    {
+        for (bool ran = true; ran;)
+        {
+            ran = false;
+            for (auto& q : queues)
+            {
+                Task task;
+                {
+                    std::lock_guard<std::mutex> lock(q->mutex);
+                    if (!q->pinned.empty())
+                    {
+                        task = std::move(q->pinned.front());
+                        q->pinned.pop_front();
+                    }
+                    else if (!q->tasks.empty())
+                    {
+                        task = std::move(q->tasks.front());
+                        q->tasks.pop_front();
+                    }
+                }
+                if (task)
+                {
+                    task();
+                    ran = true;
+                }
+            }
+        }
+        // счётчики новых очередей начинаются с нуля
+        queued = 0;
+    }
+
+    bool take(Task& task)
+    {
+        size_t n = queues.size();
+        if (currentPool == this)
+        {
+            TQueue& own = *queues[currentIndex];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.pinned.empty())
+            {
+                task = std::move(own.pinned.front());
+                own.pinned.pop_front();
+                own.pinnedCount.fetch_sub(1);
+                return true;
+            }
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+        size_t first = currentPool == this ? currentIndex + 1 : 0;
+        for (size_t k = 0; k < n; ++k)
+        {
+            TQueue& victim = *queues[(first + k) % n];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void pinToCpu(size_t cpu)
+    {
+#if defined(__linux__)
+        size_t count = std::max<size_t>(1, std::thread::hardware_concurrency());
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(static_cast<int>(cpu % count), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)cpu;
+#endif
+    }
+
+    void workerLoop(size_t index)
+    {
+        currentPool = this;
+        currentIndex = index;
+        while (!stopping)
+        {
+            if (TryRunOne())
+                continue;
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            TQueue& own = *queues[index];
+            wake.wait(lock, [this, &own] { return stopping || queued.load() > 0 || own.pinnedCount.load() > 0; });
+        }
+    }
+};
+
+// Группа задач с ожиданием их завершения;
+// первое исключение из задач пробрасывается из Wait
+class TTaskGroup
+{
+public:
+    explicit TTaskGroup(TThreadPool& p = TThreadPool::Instance()) : pool(p) {}
+    TTaskGroup(const TTaskGroup&) = delete;
+    TTaskGroup& operator=(const TTaskGroup&) = delete;
+    ~TTaskGroup()
+    {
+        // задачи ссылаются на группу, поэтому дожидаемся их в любом случае
+        while (pending.load() > 0)
+            if (!pool.TryRunOne())
+                std::this_thread::yield();
+    }
+
+    template<typename F>
+    void Run(F f)
+    {
+        pending.fetch_add(1);
+        pool.Submit([this, f]() mutable {
+            try { f(); }
+            catch (...) { setError(std::current_exception()); }
+            pending.fetch_sub(1);
+        });
+    }
+    // выполнение задачи в текущем потоке с тем же учётом исключений
+    template<typename F>
+    void RunHere(F&& f)
+    {
+        try { f(); }
+        catch (...) { setError(std::current_exception()); }
+    }
+    void Wait()
+    {
+        while (pending.load() > 0)
+            if (!pool.TryRunOne())
+                std::this_thread::yield();
+        if (error)
+            std::rethrow_exception(std::exchange(error, nullptr));
+    }
+
+private:
+    TThreadPool& pool;
+    std::atomic<size_t> pending{ 0 };
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    void setError(std::exception_ptr e)
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+            error = e;
+    }
+};
+
+// Признак отмены операции - копии разделяют один флаг:
+// Cancel() в одном потоке останавливает операцию, получившую копию
+class TCancellationToken
+{
+public:
+    TCancellationToken() : cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void Cancel() noexcept
+    {
+        cancelled->store(true, std::memory_order_relaxed);
+    }
+    bool IsCancelled() const noexcept
+    {
+        return cancelled->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled;
+};
+
+// Исключения остановленной операции
+class TOperationCancelled : public std::runtime_error
+{
+public:
+    explicit TOperationCancelled(const char* msg = "Operation was cancelled") : std::runtime_error(msg) {}
+};
+class TDeadlineExceeded : public TOperationCancelled
+{
+public:
+    TDeadlineExceeded() : TOperationCancelled("Operation deadline exceeded") {}
+};
+
+// Управление длительной операцией: отмена, крайний срок и
+// progress(done, total) - число выполненных блоков из общего числа.
+// progress вызывается из рабочих потоков, но не одновременно
+// и с неубывающим done.
+struct TOperationControl
+{
+    using Clock = std::chrono::steady_clock;
+
+    TCancellationToken token;
+    Clock::time_point deadline = Clock::time_point::max();
+    std::function<void(size_t, size_t)> progress;
+
+    void SetTimeout(Clock::duration timeout)
+    {
+        deadline = Clock::now() + timeout;
+    }
+    void ThrowIfStopped() const
+    {
+        if (token.IsCancelled())
+            throw TOperationCancelled();
+        if (deadline != Clock::time_point::max() && Clock::now() >= deadline)
+            throw TDeadlineExceeded();
+    }
+};
+
+// Ход операции из total блоков: Check() перед блоком, Advance() после;
+// без control (nullptr) обе функции ничего не делают.
+// После остановки в одной задаче остальные задачи останавливаются
+// на ближайшей проверке.
+class TOperationProgress
+{
+public:
+    TOperationProgress(const TOperationControl* c, size_t totalUnits) : control(c), total(totalUnits) {}
+
+    void Check()
+    {
+        if (control == nullptr)
+            return;
+        if (stopped.load(std::memory_order_acquire))
+            std::rethrow_exception(error);
+        try
+        {
+            control->ThrowIfStopped();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!stopped.load(std::memory_order_relaxed))
+            {
+                error = std::current_exception();
+                stopped.store(true, std::memory_order_release);
+            }
+            std::rethrow_exception(error);
+        }
+    }
+    void Advance(size_t units = 1)
+    {
+        if (control == nullptr)
+            return;
+        size_t d = done.fetch_add(units, std::memory_order_relaxed) + units;
+        if (!control->progress)
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (d > reported)
+        {
+            reported = d;
+            control->progress(d, total);
+        }
+    }
+
+private:
+    const TOperationControl* control;
+    size_t total;
+    std::atomic<size_t> done{ 0 };
+    std::atomic<bool> stopped{ false };
+    std::exception_ptr error;
+    std::mutex mutex;
+    size_t reported = 0;
+};
+
+// Разбиение [0, n) на count непрерывных кусков почти равной длины
+struct TChunking
+{
+    size_t n;
+    size_t count;
+
+    size_t begin(size_t c) const noexcept { return c * (n / count) + std::min(c, n % count); }
+    size_t end(size_t c) const noexcept { return begin(c + 1); }
+};
+
+// несколько кусков не меньше grain на каждый поток пула
+inline TChunking MakeChunking(size_t n, size_t grain)
+{
+    grain = std::max<size_t>(grain, 1);
+    size_t threads = TThreadPool::GetConcurrency();
+    size_t limit = threads == 1 ? 1 : threads * PARALLEL_CHUNKS_PER_THREAD;
+    return TChunking{ n, std::max<size_t>(1, std::min(limit, (n + grain - 1) / grain)) };
+}
+inline TChunking MakeChunking(TSequencedPolicy, size_t n, size_t)
+{
+    return TChunking{ n, 1 };
+}
+inline TChunking MakeChunking(TParallelPolicy, size_t n, size_t grain)
+{
+    return MakeChunking(n, grain);
+}
+inline TChunking MakeChunking(TParallelUnsequencedPolicy, size_t n, size_t grain)
+{
+    return MakeChunking(n, grain);
+}
+// ceil(n / grain) кусков независимо от числа потоков
+inline TChunking MakeChunking(TDeterministicPolicy, size_t n, size_t grain)
+{
+    grain = std::max<size_t>(grain, 1);
+    return TChunking{ n, std::max<size_t>(1, (n + grain - 1) / grain) };
+}
+
+// Статическое разбиение [0, n) на куски по числу потоков пула:
+// кусок 0 выполняет вызывающий поток, кусок c - рабочий поток c - 1,
+// одинаково при каждом вызове (для размещения памяти по первому касанию)
+template<typename F>
+void ParallelForStatic(size_t n, F&& body)
+{
+    TThreadPool& pool = TThreadPool::Instance();
+    TChunking chunks{ n, std::max<size_t>(1, std::min(n, pool.GetWorkerCount() + 1)) };
+    if (chunks.count <= 1)
+    {
+        if (n != 0)
+            body(size_t(0), n);
+        return;
+    }
+
+    std::atomic<size_t> pending{ chunks.count - 1 };
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto run = [&](size_t c) {
+        try { body(chunks.begin(c), chunks.end(c)); }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error)
+                error = std::current_exception();
+        }
+    };
+    for (size_t c = 1; c < chunks.count; ++c)
+        pool.SubmitTo(c - 1, [&, c] { run(c); pending.fetch_sub(1); });
+    run(0);
+    while (pending.load() > 0)
+        if (!pool.TryRunOne())
+            std::this_thread::yield();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+// Разбиение [0, n) на непрерывные куски не меньше grain
+// и их обработка в пуле потоков: body(first, last)
+template<typename F>
+void ParallelFor(size_t n, size_t grain, F&& body)
+{
+    if (n == 0)
+        return;
+
+    TChunking chunks = MakeChunking(n, grain);
+    if (chunks.count <= 1)
+    {
+        body(size_t(0), n);
+        return;
+    }
+    if (TThreadPool::GetPlacement() != TMemoryPlacement::Default)
+    {
+        ParallelForStatic(n, body);
+        return;
+    }
+
+    TTaskGroup group;
+    for (size_t c = 1; c < chunks.count; ++c)
+        group.Run([&body, chunks, c] { body(chunks.begin(c), chunks.end(c)); });
+    group.RunHere([&] { body(size_t(0), chunks.end(0)); });
+    group.Wait();
+}
+
+// Обход диапазона в соответствии с политикой
+template<typename F>
+void ForEachChunk(TSequencedPolicy, size_t n, size_t, F&& body)
+{
+    if (n != 0)
+        body(size_t(0), n);
+}
+template<typename F>
+void ForEachChunk(TParallelPolicy, size_t n, size_t grain, F&& body)
+{
+    ParallelFor(n, grain, body);
+}
+// ядра пишутся без зависимостей между итерациями и векторизуются
+// компилятором, поэтому par_unseq отличается от par только названием
+template<typename F>
+void ForEachChunk(TParallelUnsequencedPolicy, size_t n, size_t grain, F&& body)
+{
+    ParallelFor(n, grain, body);
+}
+// обход не зависит от разбиения, детерминированность обеспечивают
+// MakeChunking и ReduceChunks
+template<typename F>
+void ForEachChunk(TDeterministicPolicy, size_t n, size_t grain, F&& body)
+{
+    ParallelFor(n, grain, body);
+}
+
+// Редукция: partial(first, last) считает частичный результат непустого куска,
+// частичные результаты объединяются combine в порядке следования кусков
+// (combine должна быть ассоциативной); при exec_par_det - попарным деревом
+// над кусками фиксированного размера
+template<typename Policy, typename R, typename F, typename C>
+R ReduceChunks(const Policy& policy, size_t n, size_t grain, R init, F&& partial, C&& combine)
+{
+    if (n == 0)
+        return init;
+
+    TChunking chunks = MakeChunking(policy, n, grain);
+    std::vector<R> partials(chunks.count, init);
+    ForEachChunk(policy, chunks.count, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c)
+            partials[c] = partial(chunks.begin(c), chunks.end(c));
+    });
+
+    if constexpr (std::is_same<std::decay_t<Policy>, TDeterministicPolicy>::value)
+    {
+        for (size_t m = partials.size(); m > 1; m = (m + 1) / 2)
+        {
+            for (size_t i = 0; i < m / 2; ++i)
+                partials[i] = combine(partials[2 * i], partials[2 * i + 1]);
+            if (m % 2 != 0)
+                partials[m / 2] = partials[m - 1];
+        }
+        return combine(init, partials[0]);
+    }
+    else
+    {
+        R result = init;
+        for (const R& p : partials)
+            result = combine(result, p);
+        return result;
+    }
+}
+template<typename Policy, typename R, typename F>
+R ReduceChunks(const Policy& policy, size_t n, size_t grain, R init, F&& partial)
+{
+    return ReduceChunks(policy, n, grain, init, partial, [](const R& a, const R& b) { return a + b; });
+}
+
+// Обход строк [0, n) кусками примерно равной работы: работа строк [0, i) -
+// prefix[i] + i (prefix - префиксные суммы весов строк, n + 1 элемент,
+// prefix[0] = 0; единица на строку - пустые строки тоже не бесплатны).
+// body(first, last) вызывается для каждого непустого куска строк
+template<typename Policy, typename F>
+void ForEachWeightedChunk(const Policy& policy, size_t n, const size_t* prefix, F&& body, size_t grain = PARALLEL_MIN_CHUNK)
+{
+    // первая строка, с которой начинается work-й элемент работы
+    auto rowByWork = [n, prefix](size_t work) {
+        size_t lo = 0, hi = n;
+        while (lo < hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            if (prefix[mid] + mid < work)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    };
+    TChunking chunks = MakeChunking(policy, prefix[n] + n, grain);
+    ForEachChunk(policy, chunks.count, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c)
+        {
+            size_t i = rowByWork(chunks.begin(c));
+            size_t e = c + 1 == chunks.count ? n : rowByWork(chunks.end(c));
+            if (i < e)
+                body(i, e);
+        }
+    });
+}
+
+// Префиксные суммы a[0, n) в r (r может совпадать с a) в два прохода:
+// суммы кусков, затем сканирование кусков от своих смещений.
+// Возвращает init + сумму всех элементов.
+template<typename Policy, typename T>
+T ScanChunks(const Policy& policy, const T* a, T* r, size_t n, T init, bool inclusive)
+{
+    if (n == 0)
+        return init;
+
+    TChunking chunks = MakeChunking(policy, n, PARALLEL_MIN_CHUNK);
+    // проход 1: суммы всех кусков, кроме последнего
+    std::vector<T> offsets(chunks.count + 1, T());
+    ForEachChunk(policy, chunks.count - 1, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c)
+        {
+            T s{};
+            for (size_t i = chunks.begin(c), e = chunks.end(c); i < e; ++i)
+                s += a[i];
+            offsets[c + 1] = s;
+        }
+    });
+    offsets[0] = init;
+    for (size_t c = 1; c < chunks.count; ++c)
+        offsets[c] += offsets[c - 1];
+    // проход 2
+    ForEachChunk(policy, chunks.count, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c)
+        {
+            T s = offsets[c];
+            size_t i = chunks.begin(c), e = chunks.end(c);
+            if (inclusive)
+                for (; i < e; ++i)
+                {
+                    s += a[i];
+                    r[i] = s;
+                }
+            else
+                for (; i < e; ++i)
+                {
+                    T x = a[i];
+                    r[i] = s;
+                    s += x;
+                }
+            if (c == chunks.count - 1)
+                offsets[chunks.count] = s;
+        }
+    });
+    return offsets[chunks.count];
+}
+
+#endif
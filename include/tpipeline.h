@@ -0,0 +1,345 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Конвейер на сопрограммах C++20: чтение - вычисление - запись
+
+#ifndef __TPipeline_H__
+#define __TPipeline_H__
+
+#if !defined(__cpp_impl_coroutine)
+#error "tpipeline.h requires C++20 coroutines"
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "tmatrix.h"
+
+// Ограниченный канал между стадиями конвейера.
+// co_await Push(v) приостанавливает стадию, пока канал полон,
+// co_await Pop() - пока он пуст; после Close() Pop возвращает пустое
+// значение, когда элементы закончатся, а Push - false
+// (получатель завершился, дальше производить не нужно).
+// Приостановленные стадии возобновляются в пуле потоков.
+template<typename T>
+class TChannel
+{
+public:
+    explicit TChannel(size_t capacity = 1) : cap(capacity) {}
+    TChannel(const TChannel&) = delete;
+    TChannel& operator=(const TChannel&) = delete;
+
+    class TPushAwaiter
+    {
+    public:
+        TPushAwaiter(TChannel& c, T v) : ch(c), value(std::move(v)) {}
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            std::lock_guard<std::mutex> lock(ch.mutex);
+            if (ch.closed)
+            {
+                failed = true;
+                return false;
+            }
+            if (!ch.poppers.empty())
+            {
+                TPopper p = ch.poppers.front();
+                ch.poppers.pop_front();
+                *p.slot = std::move(value);
+                resume(p.handle);
+                return false;
+            }
+            if (ch.items.size() < ch.cap)
+            {
+                ch.items.push_back(std::move(value));
+                return false;
+            }
+            ch.pushers.push_back({ h, &value, &failed });
+            return true;
+        }
+        bool await_resume() const noexcept
+        {
+            return !failed;
+        }
+
+    private:
+        TChannel& ch;
+        T value;
+        bool failed = false;
+    };
+
+    class TPopAwaiter
+    {
+    public:
+        explicit TPopAwaiter(TChannel& c) : ch(c) {}
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            std::lock_guard<std::mutex> lock(ch.mutex);
+            if (!ch.items.empty())
+            {
+                result = std::move(ch.items.front());
+                ch.items.pop_front();
+                if (!ch.pushers.empty())
+                {
+                    TPusher p = ch.pushers.front();
+                    ch.pushers.pop_front();
+                    ch.items.push_back(std::move(*p.value));
+                    resume(p.handle);
+                }
+                return false;
+            }
+            if (!ch.pushers.empty())
+            {
+                TPusher p = ch.pushers.front();
+                ch.pushers.pop_front();
+                result = std::move(*p.value);
+                resume(p.handle);
+                return false;
+            }
+            if (ch.closed)
+                return false;
+            ch.poppers.push_back({ h, &result });
+            return true;
+        }
+        std::optional<T> await_resume()
+        {
+            return std::move(result);
+        }
+
+    private:
+        TChannel& ch;
+        std::optional<T> result;
+    };
+
+    TPushAwaiter Push(T value)
+    {
+        return TPushAwaiter(*this, std::move(value));
+    }
+    TPopAwaiter Pop()
+    {
+        return TPopAwaiter(*this);
+    }
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed)
+            return;
+        closed = true;
+        for (TPopper& p : poppers)
+            resume(p.handle);
+        poppers.clear();
+        for (TPusher& p : pushers)
+        {
+            *p.failed = true;
+            resume(p.handle);
+        }
+        pushers.clear();
+    }
+
+private:
+    struct TPusher
+    {
+        std::coroutine_handle<> handle;
+        T* value;
+        bool* failed;
+    };
+    struct TPopper
+    {
+        std::coroutine_handle<> handle;
+        std::optional<T>* slot;
+    };
+
+    size_t cap;
+    std::mutex mutex;
+    std::deque<T> items;
+    std::deque<TPusher> pushers;
+    std::deque<TPopper> poppers;
+    bool closed = false;
+
+    static void resume(std::coroutine_handle<> h)
+    {
+        TThreadPool::Instance().Submit([h] { h.resume(); });
+    }
+};
+
+// закрывает канал при выходе из стадии (в том числе по исключению),
+// чтобы соседние стадии не ждали вечно
+template<typename T>
+class TChannelCloser
+{
+public:
+    explicit TChannelCloser(TChannel<T>& c) : ch(c) {}
+    ~TChannelCloser() { ch.Close(); }
+
+private:
+    TChannel<T>& ch;
+};
+
+// Стадия конвейера - сопрограмма, запускаемая TPipeline::Run
+class TStage
+{
+public:
+    struct promise_type
+    {
+        std::exception_ptr error;
+        std::function<void()> onDone;
+
+        TStage get_return_object()
+        {
+            return TStage(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept
+        {
+            struct TFinal
+            {
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> h) noexcept
+                {
+                    // после сигнала кадр может быть уничтожен владельцем
+                    std::function<void()> done = std::move(h.promise().onDone);
+                    if (done)
+                        done();
+                }
+                void await_resume() const noexcept {}
+            };
+            return TFinal{};
+        }
+        void return_void() {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    TStage(TStage&& s) noexcept : handle(std::exchange(s.handle, nullptr)) {}
+    TStage& operator=(TStage&& s) noexcept
+    {
+        if (this != &s)
+        {
+            if (handle)
+                handle.destroy();
+            handle = std::exchange(s.handle, nullptr);
+        }
+        return *this;
+    }
+    TStage(const TStage&) = delete;
+    TStage& operator=(const TStage&) = delete;
+    ~TStage()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+private:
+    friend class TPipeline;
+
+    explicit TStage(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Конвейер: все стадии выполняются одновременно в пуле потоков,
+// Run ждёт их завершения и пробрасывает первое исключение
+class TPipeline
+{
+public:
+    TPipeline& Add(TStage stage)
+    {
+        stages.push_back(std::move(stage));
+        return *this;
+    }
+
+    void Run()
+    {
+        struct TCounter
+        {
+            std::mutex mutex;
+            std::condition_variable done;
+            size_t remaining = 0;
+        };
+        auto counter = std::make_shared<TCounter>();
+        counter->remaining = stages.size();
+
+        TThreadPool& pool = TThreadPool::Instance();
+        for (TStage& s : stages)
+        {
+            s.handle.promise().onDone = [counter] {
+                std::lock_guard<std::mutex> lock(counter->mutex);
+                if (--counter->remaining == 0)
+                    counter->done.notify_all();
+            };
+            std::coroutine_handle<> h = s.handle;
+            pool.Submit([h] { h.resume(); });
+        }
+
+        std::unique_lock<std::mutex> lock(counter->mutex);
+        while (counter->remaining > 0)
+        {
+            lock.unlock();
+            bool ran = pool.TryRunOne();
+            lock.lock();
+            if (!ran)
+                counter->done.wait_for(lock, std::chrono::milliseconds(1));
+        }
+        lock.unlock();
+
+        std::vector<TStage> finished = std::move(stages);
+        stages.clear();
+        for (TStage& s : finished)
+            if (s.handle.promise().error)
+                std::rethrow_exception(s.handle.promise().error);
+    }
+
+private:
+    std::vector<TStage> stages;
+};
+
+// Стадия чтения: матрицы size x size подряд из потока до его конца
+template<typename T>
+TStage ReadMatrices(istream& istr, size_t size, TChannel<TDynamicMatrix<T>>& out)
+{
+    TChannelCloser<TDynamicMatrix<T>> closer(out);
+    while (true)
+    {
+        istr >> std::ws;
+        if (istr.eof())
+            break;
+        TDynamicMatrix<T> m(static_cast<int>(size));
+        if (!(istr >> m))
+            throw runtime_error("Failed to read matrix");
+        if (!co_await out.Push(std::move(m)))
+            break;
+    }
+}
+
+// Стадия вычисления: out <- f(in) для каждого элемента
+template<typename In, typename Out, typename F>
+TStage Transform(TChannel<In>& in, TChannel<Out>& out, F f)
+{
+    TChannelCloser<In> inCloser(in);
+    TChannelCloser<Out> outCloser(out);
+    while (std::optional<In> item = co_await in.Pop())
+        if (!co_await out.Push(f(std::move(*item))))
+            break;
+}
+
+// Стадия записи: матрицы в поток через пустую строку
+template<typename T>
+TStage WriteMatrices(TChannel<TDynamicMatrix<T>>& in, ostream& ostr)
+{
+    TChannelCloser<TDynamicMatrix<T>> closer(in);
+    while (std::optional<TDynamicMatrix<T>> m = co_await in.Pop())
+        if (!(ostr << *m << "\n"))
+            throw runtime_error("Failed to write matrix");
+}
+
+#endif
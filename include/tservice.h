@@ -0,0 +1,719 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Локальный вычислительный сервис: задания через разделяемую память POSIX
+
+#ifndef __TService_H__
+#define __TService_H__
+
+#if !defined(__unix__) && !defined(__APPLE__)
+#error "tservice.h requires POSIX shared memory"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tmatrix.h"
+
+// Операции сервиса над матрицами double размера n x n (по строкам подряд):
+//   Multiply       - c = a * b;
+//   MultiplyVector - c = a * b, где b и c - векторы длины n.
+enum class TServiceOp : uint32_t { Multiply = 1, MultiplyVector = 2 };
+
+// Разметка сегмента разделяемой памяти: заголовок, кольцо индексов
+// отправленных заданий и слоты заданий. Слот содержит сами операнды
+// и результат: клиент пишет операнды прямо в слот, сервис читает их
+// оттуда же, поэтому данные между процессами не копируются.
+struct TServiceLayout
+{
+    static const uint32_t Magic = 0x544d5356; // "TMSV"
+    static const uint32_t Version = 3;
+
+    enum TSlotState : uint32_t { Free, Writing, Submitted, Running, Done, Failed };
+
+    struct THeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slotCount;
+        uint32_t maxSize;
+        int32_t owner;            // pid процесса сервиса
+        uint64_t slotStride;
+        pthread_mutex_t mutex;
+        pthread_cond_t submitted; // ждёт сервис
+        pthread_cond_t completed; // ждут клиенты
+        uint64_t head;            // кольцо индексов (под mutex)
+        uint64_t tail;
+        std::atomic<uint32_t> ready;
+        std::atomic<uint32_t> stop;
+    };
+    struct TSlot
+    {
+        std::atomic<uint32_t> state;
+        std::atomic<int32_t> client; // pid занявшего слот клиента, 0 - свободен
+        uint32_t op;
+        uint32_t n;
+        char error[112];
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory requires lock-free atomics");
+    static_assert(std::atomic<int32_t>::is_always_lock_free, "Shared memory requires lock-free atomics");
+
+    // процесс существует (EPERM - существует, но принадлежит другому пользователю)
+    static bool alive(int32_t pid) noexcept
+    {
+        return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+    }
+
+    static size_t align(size_t bytes) noexcept
+    {
+        return (bytes + 63) / 64 * 64;
+    }
+    static size_t ringOffset() noexcept
+    {
+        return align(sizeof(THeader));
+    }
+    static size_t slotsOffset(size_t slotCount) noexcept
+    {
+        return ringOffset() + align(slotCount * sizeof(uint32_t));
+    }
+    static size_t slotStride(size_t maxSize) noexcept
+    {
+        return align(sizeof(TSlot)) + align(3 * maxSize * maxSize * sizeof(double));
+    }
+    static size_t totalSize(size_t slotCount, size_t maxSize) noexcept
+    {
+        return slotsOffset(slotCount) + slotCount * slotStride(maxSize);
+    }
+};
+
+// Общая часть сервиса и клиента: отображённый сегмент
+class TServiceSegment
+{
+public:
+    TServiceSegment(const TServiceSegment&) = delete;
+    TServiceSegment& operator=(const TServiceSegment&) = delete;
+
+    uint32_t GetSlotCount() const noexcept { return slotCount; }
+    uint32_t GetMaxSize() const noexcept { return maxSize; }
+
+protected:
+    using Layout = TServiceLayout;
+
+    void* base = MAP_FAILED;
+    size_t bytes = 0;
+    Layout::THeader* header = nullptr;
+    // разметка сегмента: заголовок может испортить любой процесс,
+    // поэтому адреса слотов считаются только по этим копиям
+    uint32_t slotCount = 0;
+    uint32_t maxSize = 0;
+    uint64_t stride = 0;
+
+    TServiceSegment() = default;
+    ~TServiceSegment()
+    {
+        if (base != MAP_FAILED)
+            munmap(base, bytes);
+    }
+
+    void map(int fd, size_t size)
+    {
+        bytes = size;
+        base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED)
+            throw runtime_error(std::string("Failed to map service memory: ") + std::strerror(errno));
+        header = static_cast<Layout::THeader*>(base);
+    }
+
+    uint32_t* ring() const noexcept
+    {
+        return reinterpret_cast<uint32_t*>(static_cast<char*>(base) + Layout::ringOffset());
+    }
+    Layout::TSlot* slot(uint32_t i) const
+    {
+        if (i >= slotCount)
+            throw out_of_range("Service slot index is out of range");
+        char* p = static_cast<char*>(base) + Layout::slotsOffset(slotCount) + i * stride;
+        return reinterpret_cast<Layout::TSlot*>(p);
+    }
+    static double* slotData(Layout::TSlot* s) noexcept
+    {
+        return reinterpret_cast<double*>(reinterpret_cast<char*>(s) + Layout::align(sizeof(Layout::TSlot)));
+    }
+
+    // блокировка, переживающая аварийное завершение владельца
+    void lock() const
+    {
+        int rc = pthread_mutex_lock(&header->mutex);
+#if defined(__linux__)
+        if (rc == EOWNERDEAD)
+            rc = pthread_mutex_consistent(&header->mutex);
+#endif
+        if (rc != 0)
+            throw runtime_error("Failed to lock service mutex");
+    }
+    void unlock() const noexcept
+    {
+        pthread_mutex_unlock(&header->mutex);
+    }
+    // ожидание условия не дольше timeoutMs
+    void waitFor(pthread_cond_t* cond, long timeoutMs) const
+    {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += timeoutMs / 1000;
+        ts.tv_nsec += (timeoutMs % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        int rc = pthread_cond_timedwait(cond, &header->mutex, &ts);
+#if defined(__linux__)
+        if (rc == EOWNERDEAD)
+            pthread_mutex_consistent(&header->mutex);
+#endif
+    }
+};
+
+// Сервис - резидентный процесс, владеющий сегментом name ("/имя").
+// Run() выполняет задания до Stop(): все накопившиеся задания
+// забираются пачкой, упорядочиваются по убыванию трудоёмкости и
+// выполняются в общем пуле потоков (каждое - параллельно внутри),
+// поэтому мелкие задания разных клиентов занимают ядра одновременно,
+// а пул потоков и кэши остаются "прогретыми" между заданиями.
+class TService : public TServiceSegment
+{
+public:
+    TService(const std::string& segmentName, uint32_t slotCount, uint32_t maxSize) : name(segmentName)
+    {
+        if (slotCount == 0)
+            throw invalid_argument("Service should have at least one slot");
+        if (maxSize == 0 || maxSize > MAX_MATRIX_SIZE)
+            throw invalid_argument("Service matrix size should be in (0, MAX_MATRIX_SIZE]");
+
+        reclaimStale(name);
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+        {
+            if (errno == EEXIST)
+                throw runtime_error("Matrix service is already running");
+            throw runtime_error(std::string("Failed to create service memory: ") + std::strerror(errno));
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0)
+        {
+            device = st.st_dev;
+            inode = st.st_ino;
+        }
+        size_t size = Layout::totalSize(slotCount, maxSize);
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            throw runtime_error(std::string("Failed to size service memory: ") + std::strerror(errno));
+        }
+        try
+        {
+            map(fd, size);
+        }
+        catch (...)
+        {
+            shm_unlink(name.c_str());
+            throw;
+        }
+
+        this->slotCount = slotCount;
+        this->maxSize = maxSize;
+        stride = Layout::slotStride(maxSize);
+        header = new (base) Layout::THeader();
+        header->magic = Layout::Magic;
+        header->version = Layout::Version;
+        header->slotCount = slotCount;
+        header->maxSize = maxSize;
+        header->owner = static_cast<int32_t>(getpid());
+        header->slotStride = stride;
+        header->head = header->tail = 0;
+        header->stop.store(0);
+
+        pthread_mutexattr_t ma;
+        pthread_mutexattr_init(&ma);
+        pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+#if defined(__linux__)
+        pthread_mutexattr_setrobust(&ma, PTHREAD_MUTEX_ROBUST);
+#endif
+        pthread_mutex_init(&header->mutex, &ma);
+        pthread_mutexattr_destroy(&ma);
+
+        pthread_condattr_t ca;
+        pthread_condattr_init(&ca);
+        pthread_condattr_setpshared(&ca, PTHREAD_PROCESS_SHARED);
+        pthread_cond_init(&header->submitted, &ca);
+        pthread_cond_init(&header->completed, &ca);
+        pthread_condattr_destroy(&ca);
+
+        for (uint32_t i = 0; i < slotCount; ++i)
+            new (slot(i)) Layout::TSlot();
+        header->ready.store(1, std::memory_order_release);
+    }
+    ~TService()
+    {
+        Stop();
+        try
+        {
+            lock();
+            pthread_cond_broadcast(&header->completed);
+            unlock();
+        }
+        catch (...) {}
+        // имя могло перейти к сервису, запущенному после аварии этого процесса
+        if (ownsName())
+            shm_unlink(name.c_str());
+    }
+
+    // безопасно вызывать из обработчика сигнала
+    void Stop() noexcept
+    {
+        header->stop.store(1, std::memory_order_release);
+    }
+
+    void Run()
+    {
+        TThreadPool& pool = TThreadPool::Instance();
+        while (header->stop.load(std::memory_order_acquire) == 0)
+        {
+            std::vector<uint32_t> batch = take();
+            if (!batch.empty())
+            {
+                dispatch(pool, batch);
+                continue;
+            }
+            // пока задания выполняются, поток сервиса помогает пулу
+            if (inFlight.load() > 0 && pool.TryRunOne())
+                continue;
+            lock();
+            if (header->head == header->tail)
+                waitFor(&header->submitted, inFlight.load() > 0 ? 1 : 100);
+            unlock();
+        }
+        while (inFlight.load() > 0)
+            if (!pool.TryRunOne())
+                std::this_thread::yield();
+    }
+
+private:
+    std::string name;
+    dev_t device = 0;
+    ino_t inode = 0;
+    std::atomic<size_t> inFlight{ 0 };
+
+    // Сегмент с тем же именем удаляется, только если это сегмент сервиса,
+    // записавшего свой pid и уже завершившегося. Сегмент работающего или
+    // ещё запускающегося сервиса (pid не записан) и чужой сегмент не трогаются
+    static void reclaimStale(const std::string& name)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+            return;
+        bool stale = false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Layout::THeader)))
+        {
+            void* p = mmap(nullptr, sizeof(Layout::THeader), PROT_READ, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                // начало заголовка до owner одинаково во всех версиях с owner
+                const Layout::THeader* h = static_cast<const Layout::THeader*>(p);
+                stale = h->magic == Layout::Magic && h->version >= 2 && h->owner > 0 && !Layout::alive(h->owner);
+                munmap(p, sizeof(Layout::THeader));
+            }
+        }
+        close(fd);
+        if (!stale)
+            throw runtime_error("Matrix service is already running");
+        shm_unlink(name.c_str());
+    }
+
+    bool ownsName() const noexcept
+    {
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        bool same = fstat(fd, &st) == 0 && st.st_dev == device && st.st_ino == inode;
+        close(fd);
+        return same;
+    }
+
+    // Кольцо и слоты пишут клиенты, поэтому индексы проверяются, а слот
+    // забирается переходом Submitted -> Running: повторно поставленный
+    // или не отправленный слот пропускается
+    std::vector<uint32_t> take()
+    {
+        std::vector<uint32_t> batch;
+        auto claim = [this, &batch](uint32_t i) {
+            uint32_t expected = Layout::Submitted;
+            if (i < slotCount && slot(i)->state.compare_exchange_strong(expected, Layout::Running, std::memory_order_acquire))
+                batch.push_back(i);
+        };
+        lock();
+        // в кольце не бывает больше slotCount заданий - иначе оно испорчено
+        // и отправленные задания ищутся по состояниям слотов
+        if (header->tail - header->head > slotCount)
+        {
+            header->head = header->tail;
+            for (uint32_t i = 0; i < slotCount; ++i)
+                claim(i);
+        }
+        for (; header->head != header->tail; ++header->head)
+            claim(ring()[header->head % slotCount]);
+        unlock();
+        return batch;
+    }
+
+    double cost(const Layout::TSlot* s) const noexcept
+    {
+        double n = std::min(s->n, maxSize);
+        return s->op == static_cast<uint32_t>(TServiceOp::Multiply) ? n * n * n : n * n;
+    }
+
+    void dispatch(TThreadPool& pool, std::vector<uint32_t>& batch)
+    {
+        // сначала длинные задания - меньше простоя в конце пачки
+        std::stable_sort(batch.begin(), batch.end(), [this](uint32_t x, uint32_t y) {
+            return cost(slot(x)) > cost(slot(y));
+        });
+        for (uint32_t i : batch)
+        {
+            Layout::TSlot* s = slot(i);
+            inFlight++;
+            pool.Submit([this, s] {
+                execute(s);
+                inFlight--;
+            });
+        }
+    }
+
+    void execute(Layout::TSlot* s)
+    {
+        uint32_t state = Layout::Done;
+        try
+        {
+            // поля слота читаются один раз: клиент может менять их и сейчас
+            size_t n = s->n;
+            uint32_t op = s->op;
+            if (n == 0 || n > maxSize)
+                throw invalid_argument("Matrix size is not supported by the service");
+            double* a = slotData(s);
+            double* b = a + n * n;
+            double* c = b + n * n;
+            switch (static_cast<TServiceOp>(op))
+            {
+            case TServiceOp::Multiply:
+                multiply(a, b, c, n);
+                break;
+            case TServiceOp::MultiplyVector:
+                multiplyVector(a, b, c, n);
+                break;
+            default:
+                throw invalid_argument("Unknown service operation");
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::strncpy(s->error, e.what(), sizeof(s->error) - 1);
+            s->error[sizeof(s->error) - 1] = '\0';
+            state = Layout::Failed;
+        }
+        s->state.store(state, std::memory_order_release);
+        lock();
+        pthread_cond_broadcast(&header->completed);
+        unlock();
+    }
+
+    // ядра над строками в разделяемой памяти (порядок i-k-j, как в TDynamicMatrix)
+    static void multiply(const double* a, const double* b, double* c, size_t n)
+    {
+        ParallelFor(n, std::max<size_t>(1, PARALLEL_MIN_CHUNK / (n * n + 1)), [=](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                double* ci = c + i * n;
+                std::fill(ci, ci + n, 0.0);
+                for (size_t k = 0; k < n; ++k)
+                {
+                    const double aik = a[i * n + k];
+                    const double* bk = b + k * n;
+                    for (size_t j = 0; j < n; ++j)
+                        ci[j] += aik * bk[j];
+                }
+            }
+        });
+    }
+    static void multiplyVector(const double* a, const double* x, double* y, size_t n)
+    {
+        ParallelFor(n, std::max<size_t>(1, PARALLEL_MIN_CHUNK / n), [=](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                const double* ai = a + i * n;
+                double s = 0;
+                for (size_t j = 0; j < n; ++j)
+                    s += ai[j] * x[j];
+                y[i] = s;
+            }
+        });
+    }
+};
+
+class TServiceClient;
+
+// Задание в слоте сервиса: операнды заполняются на месте (Operand),
+// результат читается на месте (Result). Слот освобождается деструктором.
+class TServiceJob
+{
+public:
+    TServiceJob(TServiceJob&& j) noexcept
+        : client(std::exchange(j.client, nullptr)), s(j.s), index(j.index) {}
+    TServiceJob& operator=(TServiceJob&&) = delete;
+    TServiceJob(const TServiceJob&) = delete;
+    ~TServiceJob();
+
+    TServiceOp GetOp() const noexcept { return static_cast<TServiceOp>(s->op); }
+    size_t GetSize() const noexcept { return s->n; }
+
+    // операнд 0 - матрица n x n; операнд 1 - матрица или вектор
+    double* Operand(size_t k)
+    {
+        if (k > 1)
+            throw out_of_range("Service operation has two operands");
+        return data() + k * GetSize() * GetSize();
+    }
+    const double* Result() const
+    {
+        if (s->state.load(std::memory_order_acquire) != TServiceLayout::Done)
+            throw logic_error("Service job is not completed");
+        return data() + 2 * GetSize() * GetSize();
+    }
+
+private:
+    friend class TServiceClient;
+
+    TServiceClient* client;
+    TServiceLayout::TSlot* s;
+    uint32_t index;
+
+    TServiceJob(TServiceClient* c, TServiceLayout::TSlot* sl, uint32_t i) : client(c), s(sl), index(i) {}
+
+    double* data() const noexcept
+    {
+        return reinterpret_cast<double*>(reinterpret_cast<char*>(s) + TServiceLayout::align(sizeof(TServiceLayout::TSlot)));
+    }
+};
+
+// Клиент сервиса: подключается к существующему сегменту
+class TServiceClient : public TServiceSegment
+{
+public:
+    explicit TServiceClient(const std::string& name)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+            throw runtime_error("Matrix service is not running");
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Layout::THeader)))
+        {
+            close(fd);
+            throw runtime_error("Matrix service memory is not initialized");
+        }
+        map(fd, static_cast<size_t>(st.st_size));
+        if (header->ready.load(std::memory_order_acquire) != 1 || header->magic != Layout::Magic ||
+            header->version != Layout::Version)
+            throw runtime_error("Matrix service memory has unexpected format");
+        slotCount = header->slotCount;
+        maxSize = header->maxSize;
+        stride = header->slotStride;
+        if (slotCount == 0 || maxSize == 0 || maxSize > MAX_MATRIX_SIZE || stride != Layout::slotStride(maxSize) ||
+            bytes < Layout::totalSize(slotCount, maxSize))
+            throw runtime_error("Matrix service memory has unexpected format");
+        owner = header->owner;
+        self = static_cast<int32_t>(getpid());
+        checkRunning();
+    }
+
+    // свободный слот для операции над матрицами n x n (ждёт, если все заняты);
+    // слоты, оставшиеся от завершившихся клиентов, освобождаются
+    TServiceJob Acquire(TServiceOp op, size_t n)
+    {
+        if (n == 0 || n > maxSize)
+            throw invalid_argument("Matrix size is not supported by the service");
+        while (true)
+        {
+            for (uint32_t i = 0; i < slotCount; ++i)
+            {
+                uint32_t expected = Layout::Free;
+                Layout::TSlot* sl = slot(i);
+                if (sl->state.compare_exchange_strong(expected, Layout::Writing, std::memory_order_acquire))
+                {
+                    sl->client.store(self, std::memory_order_relaxed);
+                    sl->op = static_cast<uint32_t>(op);
+                    sl->n = static_cast<uint32_t>(n);
+                    sl->error[0] = '\0';
+                    return TServiceJob(this, sl, i);
+                }
+            }
+            checkRunning();
+            if (reclaimAbandoned())
+                continue;
+            lock();
+            waitFor(&header->completed, 10);
+            unlock();
+        }
+    }
+    void Submit(TServiceJob& job)
+    {
+        if (job.s->state.load() != Layout::Writing)
+            throw logic_error("Service job is already submitted");
+        job.s->state.store(Layout::Submitted, std::memory_order_release);
+        lock();
+        ring()[header->tail % slotCount] = job.index;
+        header->tail++;
+        pthread_cond_signal(&header->submitted);
+        unlock();
+    }
+    // ожидание результата; ошибка сервиса пробрасывается как runtime_error
+    void Wait(TServiceJob& job)
+    {
+        lock();
+        uint32_t state;
+        while ((state = job.s->state.load(std::memory_order_acquire)) != Layout::Done && state != Layout::Failed)
+        {
+            if (!running())
+            {
+                unlock();
+                throw runtime_error("Matrix service has stopped");
+            }
+            waitFor(&header->completed, 100);
+        }
+        unlock();
+        if (state == Layout::Failed)
+            throw runtime_error(job.s->error);
+    }
+
+    // удобные варианты с копированием из/в TDynamicMatrix
+    TDynamicMatrix<double> Multiply(const TDynamicMatrix<double>& a, const TDynamicMatrix<double>& b)
+    {
+        size_t n = a.GetSize();
+        if (b.GetSize() != n)
+            throw invalid_argument("Matrix dimensions must match for multiplication!");
+        TServiceJob job = Acquire(TServiceOp::Multiply, n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            std::copy(a[i].data(), a[i].data() + n, job.Operand(0) + i * n);
+            std::copy(b[i].data(), b[i].data() + n, job.Operand(1) + i * n);
+        }
+        Submit(job);
+        Wait(job);
+        TDynamicMatrix<double> c(static_cast<int>(n));
+        for (size_t i = 0; i < n; ++i)
+            std::copy(job.Result() + i * n, job.Result() + (i + 1) * n, c[i].data());
+        return c;
+    }
+    TDynamicVector<double> Multiply(const TDynamicMatrix<double>& a, const TDynamicVector<double>& x)
+    {
+        size_t n = a.GetSize();
+        if (x.size() != n)
+            throw invalid_argument("Matrix columns and vector size must be equal for multiplication!");
+        TServiceJob job = Acquire(TServiceOp::MultiplyVector, n);
+        for (size_t i = 0; i < n; ++i)
+            std::copy(a[i].data(), a[i].data() + n, job.Operand(0) + i * n);
+        std::copy(x.data(), x.data() + n, job.Operand(1));
+        Submit(job);
+        Wait(job);
+        TDynamicVector<double> y(n);
+        std::copy(job.Result(), job.Result() + n, y.data());
+        return y;
+    }
+
+private:
+    friend class TServiceJob;
+
+    int32_t owner = 0; // pid сервиса
+    int32_t self = 0;
+
+    // сервис мог завершиться аварийно, не выставив stop
+    bool running() const noexcept
+    {
+        return header->stop.load() == 0 && Layout::alive(owner);
+    }
+    void checkRunning() const
+    {
+        if (!running())
+            throw runtime_error("Matrix service has stopped");
+    }
+    // Слоты завершившихся клиентов (Writing, Done, Failed - Submitted и
+    // Running ещё завершит сервис). pid обнуляется до освобождения слота,
+    // поэтому слот, только что занятый другим клиентом, не отбирается
+    bool reclaimAbandoned() noexcept
+    {
+        bool reclaimed = false;
+        for (uint32_t i = 0; i < slotCount; ++i)
+        {
+            Layout::TSlot* sl = slot(i);
+            uint32_t state = sl->state.load(std::memory_order_acquire);
+            if (state != Layout::Writing && state != Layout::Done && state != Layout::Failed)
+                continue;
+            int32_t pid = sl->client.load(std::memory_order_acquire);
+            if (pid == 0 || pid == self || Layout::alive(pid))
+                continue;
+            if (sl->client.compare_exchange_strong(pid, 0))
+            {
+                sl->state.store(Layout::Free, std::memory_order_release);
+                reclaimed = true;
+            }
+        }
+        return reclaimed;
+    }
+    // слот освобождается только после завершения задания
+    void release(TServiceJob& job) noexcept
+    {
+        uint32_t state = job.s->state.load(std::memory_order_acquire);
+        if (state == Layout::Submitted || state == Layout::Running)
+        {
+            try { Wait(job); }
+            catch (...) {}
+        }
+        job.s->client.store(0, std::memory_order_relaxed);
+        job.s->state.store(Layout::Free, std::memory_order_release);
+        try
+        {
+            lock();
+            pthread_cond_broadcast(&header->completed);
+            unlock();
+        }
+        catch (...) {}
+    }
+};
+
+inline TServiceJob::~TServiceJob()
+{
+    if (client != nullptr)
+        client->release(*this);
+}
+
+#endif
@@ -0,0 +1,1143 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Разреженные матрицы
+
+#ifndef __TSparse_H__
+#define __TSparse_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "tmatrix.h"
+
+// Устойчивая сортировка подсчётом индексов 0..n-1 по ключам key(t) < buckets:
+// ptr - начала корзин (buckets + 1 элемент), perm - индексы в порядке
+// (ключ, индекс). Подсчёт и раскладка параллельны (атомарные счётчики
+// корзин); корзины, перемешанные параллельной раскладкой, досортировываются
+// по индексу, поэтому результат не зависит от числа потоков
+template<typename Policy, typename K>
+void CountingSort(const Policy& policy, size_t n, size_t buckets, K key, std::vector<size_t>& ptr, std::vector<size_t>& perm)
+{
+    ptr.assign(buckets + 1, 0);
+    perm.resize(n);
+    if (MakeChunking(policy, n, PARALLEL_MIN_CHUNK).count == 1)
+    {
+        // один кусок - обычные счётчики, раскладка сразу устойчива
+        for (size_t t = 0; t < n; ++t)
+            ++ptr[key(t) + 1];
+        for (size_t b = 0; b < buckets; ++b)
+            ptr[b + 1] += ptr[b];
+        std::vector<size_t> cursor(ptr.begin(), ptr.end() - 1);
+        for (size_t t = 0; t < n; ++t)
+            perm[cursor[key(t)]++] = t;
+        return;
+    }
+
+    std::unique_ptr<std::atomic<size_t>[]> cursor(new std::atomic<size_t>[buckets]);
+    ForEachChunk(policy, buckets, PARALLEL_MIN_CHUNK, [&](size_t first, size_t last) {
+        for (size_t b = first; b < last; ++b)
+            cursor[b].store(0, std::memory_order_relaxed);
+    });
+    ForEachChunk(policy, n, PARALLEL_MIN_CHUNK, [&](size_t first, size_t last) {
+        for (size_t t = first; t < last; ++t)
+            cursor[key(t)].fetch_add(1, std::memory_order_relaxed);
+    });
+    ForEachChunk(policy, buckets, PARALLEL_MIN_CHUNK, [&](size_t first, size_t last) {
+        for (size_t b = first; b < last; ++b)
+            ptr[b] = cursor[b].load(std::memory_order_relaxed);
+    });
+    ptr[buckets] = ScanChunks(policy, ptr.data(), ptr.data(), buckets, size_t(0), false);
+    ForEachChunk(policy, buckets, PARALLEL_MIN_CHUNK, [&](size_t first, size_t last) {
+        for (size_t b = first; b < last; ++b)
+            cursor[b].store(ptr[b], std::memory_order_relaxed);
+    });
+    ForEachChunk(policy, n, PARALLEL_MIN_CHUNK, [&](size_t first, size_t last) {
+        for (size_t t = first; t < last; ++t)
+            perm[cursor[key(t)].fetch_add(1, std::memory_order_relaxed)] = t;
+    });
+    ForEachChunk(policy, buckets, std::max<size_t>(1, PARALLEL_MIN_CHUNK * buckets / std::max<size_t>(n, 1)), [&](size_t first, size_t last) {
+        for (size_t b = first; b < last; ++b)
+            if (!std::is_sorted(perm.begin() + ptr[b], perm.begin() + ptr[b + 1]))
+                std::sort(perm.begin() + ptr[b], perm.begin() + ptr[b + 1]);
+    });
+}
+
+// Отметки столбцов потока не короче size; неотмеченные равны Index(-1).
+// Пользователь снимает свои отметки перед возвратом (обычно после каждой
+// строки), поэтому массив переиспользуется без очистки. Массив длиннее
+// SPARSE_MARKS_KEEP, оставшийся от большой матрицы, освобождается при
+// первом вызове для вдвое меньшей - память потоков не растёт навсегда
+const size_t SPARSE_MARKS_KEEP = 1 << 18;
+
+template<typename Index>
+std::vector<Index>& ThreadMarks(size_t size)
+{
+    static thread_local std::vector<Index> mark;
+    if (mark.size() > SPARSE_MARKS_KEEP && mark.size() / 2 > size)
+        std::vector<Index>(std::max(size, SPARSE_MARKS_KEEP), static_cast<Index>(-1)).swap(mark);
+    if (mark.size() < size)
+        mark.resize(size, static_cast<Index>(-1));
+    return mark;
+}
+
+template<typename T> class TCSCMatrix;
+template<typename T> class TCOOBuilder;
+template<typename T> class TSparseProduct;
+template<typename T> class TBSRMatrix;
+
+// Разреженная матрица в формате CSR (сжатые строки) -
+// ненулевые элементы строки i хранятся в values[rowPtr[i], rowPtr[i + 1])
+// по возрастанию номеров столбцов colInd. Размеры прямоугольные и
+// не ограничены MAX_MATRIX_SIZE; индексы столбцов 32-битные.
+template<typename T>
+class TCSRMatrix
+{
+public:
+    using Index = uint32_t;
+
+    // нулевая матрица rows x cols
+    TCSRMatrix(size_t rows, size_t cols) : nRows(rows), nCols(cols), rowPtr(rows + 1, 0)
+    {
+        checkSize(rows, cols);
+    }
+    // из готовых массивов CSR (проверяются)
+    TCSRMatrix(size_t rows, size_t cols, std::vector<size_t> rowPtr, std::vector<Index> colInd, std::vector<T> values)
+        : nRows(rows), nCols(cols), rowPtr(std::move(rowPtr)), colInd(std::move(colInd)), values(std::move(values))
+    {
+        checkSize(rows, cols);
+        validate();
+    }
+    // из плотной матрицы: подсчёт ненулевых по строкам, префиксные суммы,
+    // заполнение - все три прохода параллельны по строкам
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TCSRMatrix(const Policy& policy, const TDynamicMatrix<T>& m) : nRows(m.GetSize()), nCols(m.GetSize()), rowPtr(m.GetSize() + 1, 0)
+    {
+        checkSize(nRows, nCols);
+        size_t n = nRows;
+        size_t grain = std::max<size_t>(1, PARALLEL_MIN_CHUNK / n);
+        ForEachChunk(policy, n, grain, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                const T* a = m[i].data();
+                size_t count = 0;
+                for (size_t j = 0; j < n; ++j)
+                    count += a[j] != T();
+                rowPtr[i] = count;
+            }
+        });
+        size_t nnz = ScanChunks(policy, rowPtr.data(), rowPtr.data(), n, size_t(0), false);
+        rowPtr[n] = nnz;
+        colInd.resize(nnz);
+        values.resize(nnz);
+        ForEachChunk(policy, n, grain, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                const T* a = m[i].data();
+                size_t k = rowPtr[i];
+                for (size_t j = 0; j < n; ++j)
+                    if (a[j] != T())
+                    {
+                        colInd[k] = static_cast<Index>(j);
+                        values[k++] = a[j];
+                    }
+            }
+        });
+    }
+    explicit TCSRMatrix(const TDynamicMatrix<T>& m) : TCSRMatrix(exec_par, m) {}
+
+    size_t GetRows() const noexcept { return nRows; }
+    size_t GetCols() const noexcept { return nCols; }
+    size_t GetNonZeros() const noexcept { return values.size(); }
+
+    const std::vector<size_t>& RowPtr() const noexcept { return rowPtr; }
+    const std::vector<Index>& ColIndices() const noexcept { return colInd; }
+    const std::vector<T>& Values() const noexcept { return values; }
+
+    // элемент (i, j); отсутствующий в структуре - ноль
+    T operator()(size_t i, size_t j) const
+    {
+        if (i >= nRows || j >= nCols)
+            throw out_of_range("Index out of range");
+
+        auto first = colInd.begin() + rowPtr[i], last = colInd.begin() + rowPtr[i + 1];
+        auto it = std::lower_bound(first, last, static_cast<Index>(j));
+        if (it == last || *it != j)
+            return T();
+        return values[it - colInd.begin()];
+    }
+
+    bool operator==(const TCSRMatrix& m) const noexcept
+    {
+        return nRows == m.nRows && nCols == m.nCols && rowPtr == m.rowPtr && colInd == m.colInd && values == m.values;
+    }
+    bool operator!=(const TCSRMatrix& m) const noexcept
+    {
+        return !(*this == m);
+    }
+
+    // плотная копия; TDynamicMatrix квадратная и не больше MAX_MATRIX_SIZE
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicMatrix<T> ToDense(const Policy& policy) const
+    {
+        if (nRows != nCols)
+            throw invalid_argument("Only square sparse matrix can be converted to dense");
+        if (nRows > MAX_MATRIX_SIZE)
+            throw invalid_argument("Matrix size shouldn't be more than MAX_MATRIX_SIZE");
+
+        TDynamicMatrix<T> result(static_cast<int>(nRows));
+        ForEachChunk(policy, nRows, std::max<size_t>(1, PARALLEL_MIN_CHUNK / nRows), [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                T* r = result[i].data();
+                for (size_t k = rowPtr[i]; k < rowPtr[i + 1]; ++k)
+                    r[colInd[k]] = values[k];
+            }
+        });
+        return result;
+    }
+    TDynamicMatrix<T> ToDense() const
+    {
+        return ToDense(exec_par);
+    }
+
+    // транспонированная матрица (cols x rows) сортировкой подсчётом по столбцам;
+    // она же - эта матрица в формате CSC (см. TCSCMatrix)
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TCSRMatrix Transpose(const Policy& policy) const
+    {
+        size_t nnz = values.size();
+        std::vector<Index> rowOf(nnz);
+        ForEachChunk(policy, nRows, std::max<size_t>(1, PARALLEL_MIN_CHUNK * nRows / std::max<size_t>(nnz, 1)), [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+                std::fill(rowOf.begin() + rowPtr[i], rowOf.begin() + rowPtr[i + 1], static_cast<Index>(i));
+        });
+        std::vector<size_t> ptr, perm;
+        CountingSort(policy, nnz, nCols, [this](size_t k) { return colInd[k]; }, ptr, perm);
+
+        // внутри столбца perm возрастает, то есть идёт по строкам
+        std::vector<Index> ind(nnz);
+        std::vector<T> val(nnz);
+        ForEachChunk(policy, nnz, PARALLEL_MIN_CHUNK, [&](size_t first, size_t last) {
+            for (size_t q = first; q < last; ++q)
+            {
+                ind[q] = rowOf[perm[q]];
+                val[q] = values[perm[q]];
+            }
+        });
+        return TCSRMatrix(nCols, nRows, std::move(ptr), std::move(ind), std::move(val), TTrusted{});
+    }
+    TCSRMatrix Transpose() const
+    {
+        return Transpose(exec_par);
+    }
+
+    // SpMV: y = this * x
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const
+    {
+        return multiply(exec_par, v);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicVector<T> multiply(const Policy& policy, const TDynamicVector<T>& v) const
+    {
+        if (v.size() != nCols) throw invalid_argument("Matrix columns and vector size must be equal for multiplication!");
+        TDynamicVector<T> result(nRows);
+        multiplyRows(policy, v.data(), result.data());
+        return result;
+    }
+
+    // SpGEMM: this * m (см. TSparseProduct; для повторных произведений
+    // с той же структурой выгоднее сохранить TSparseProduct)
+    TCSRMatrix operator*(const TCSRMatrix& m) const
+    {
+        return multiply(exec_par, m);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TCSRMatrix multiply(const Policy& policy, const TCSRMatrix& m) const
+    {
+        return TSparseProduct<T>(policy, *this, m).Compute(policy, *this, m);
+    }
+
+    // SpMM: this * m для квадратной матрицы размера m
+    TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& m) const
+    {
+        return multiply(exec_par, m);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicMatrix<T> multiply(const Policy& policy, const TDynamicMatrix<T>& m) const
+    {
+        size_t n = m.GetSize();
+        if (nRows != n || nCols != n)
+            throw invalid_argument("Matrix dimensions must match for multiplication!");
+
+        TDynamicMatrix<T> result(static_cast<int>(n));
+        std::vector<T*> y(n);
+        for (size_t i = 0; i < n; ++i)
+            y[i] = result[i].data();
+        multiplyBlock(policy, n, [&m](size_t j) { return m[j].data(); }, [&y](size_t i) { return y[i]; });
+        return result;
+    }
+    // Y = this * X для блока из k векторов: X - cols x k, Y - rows x k,
+    // оба по строкам подряд (строка j блока - элементы j-х компонент всех векторов)
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    void multiply(const Policy& policy, const T* x, size_t k, T* y) const
+    {
+        multiplyBlock(policy, k, [x, k](size_t j) { return x + j * k; }, [y, k](size_t i) { return y + i * k; });
+    }
+
+    // m * this для плотной матрицы m (размеры совпадают)
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicMatrix<T> multiplyLeft(const Policy& policy, const TDynamicMatrix<T>& m) const
+    {
+        size_t n = m.GetSize();
+        if (nRows != n || nCols != n)
+            throw invalid_argument("Matrix dimensions must match for multiplication!");
+
+        TDynamicMatrix<T> result(static_cast<int>(n));
+        std::vector<T*> y(n);
+        for (size_t i = 0; i < n; ++i)
+            y[i] = result[i].data();
+        multiplyBlockLeft(policy, n, [&m](size_t i) { return m[i].data(); }, [&y](size_t i) { return y[i]; });
+        return result;
+    }
+    // Y = X * this: X - m x rows, Y - m x cols, по строкам подряд
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    void multiplyLeft(const Policy& policy, const T* x, size_t m, T* y) const
+    {
+        multiplyBlockLeft(policy, m, [this, x](size_t i) { return x + i * nRows; }, [this, y](size_t i) { return y + i * nCols; });
+    }
+
+private:
+    template<typename> friend class TCSCMatrix;
+    template<typename> friend class TCOOBuilder;
+    template<typename> friend class TSparseProduct;
+    template<typename> friend class TBSRMatrix;
+
+    size_t nRows, nCols;
+    std::vector<size_t> rowPtr;
+    std::vector<Index> colInd;
+    std::vector<T> values;
+
+    // массивы заведомо корректны (собраны конвертацией) - без проверки
+    struct TTrusted {};
+    TCSRMatrix(size_t rows, size_t cols, std::vector<size_t> rowPtr, std::vector<Index> colInd, std::vector<T> values, TTrusted)
+        : nRows(rows), nCols(cols), rowPtr(std::move(rowPtr)), colInd(std::move(colInd)), values(std::move(values))
+    {
+    }
+
+    static void checkSize(size_t rows, size_t cols)
+    {
+        if (rows == 0 || cols == 0)
+            throw invalid_argument("Sparse matrix size should be greater than zero");
+        if (rows > MAX_VECTOR_SIZE || cols > MAX_VECTOR_SIZE)
+            throw invalid_argument("Sparse matrix size should be less than MAX_VECTOR_SIZE");
+    }
+
+    void validate() const
+    {
+        if (rowPtr.size() != nRows + 1 || rowPtr[0] != 0)
+            throw invalid_argument("Pointer array should have one element more than rows (columns for CSC) and start with zero");
+        if (rowPtr[nRows] != colInd.size() || colInd.size() != values.size())
+            throw invalid_argument("Index and value arrays should have as many elements as the last pointer");
+        for (size_t i = 0; i < nRows; ++i)
+            if (rowPtr[i] > rowPtr[i + 1])
+                throw invalid_argument("Pointers should not decrease");
+        for (size_t i = 0; i < nRows; ++i)
+            for (size_t k = rowPtr[i]; k < rowPtr[i + 1]; ++k)
+            {
+                if (colInd[k] >= nCols)
+                    throw invalid_argument("Index out of range");
+                if (k > rowPtr[i] && colInd[k] <= colInd[k - 1])
+                    throw invalid_argument("Indices should strictly increase within a row (a column for CSC)");
+            }
+    }
+
+    // строка i результата - сумма строк X с весами из строки i: внутренний
+    // цикл идёт по k векторам подряд и векторизуется; векторы обрабатываются
+    // полосами, чтобы полоса строки результата оставалась в кэше L1
+    template<typename Policy, typename X, typename Y>
+    void multiplyBlock(const Policy& policy, size_t k, X xrow, Y yrow) const
+    {
+        const size_t tile = 512;
+        ForEachWeightedChunk(policy, nRows, rowPtr.data(), [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                T* yi = yrow(i);
+                std::fill(yi, yi + k, T());
+                for (size_t t0 = 0; t0 < k; t0 += tile)
+                {
+                    size_t t1 = std::min(k, t0 + tile);
+                    for (size_t p = rowPtr[i]; p < rowPtr[i + 1]; ++p)
+                    {
+                        const T a = values[p];
+                        const T* xj = xrow(colInd[p]);
+                        for (size_t t = t0; t < t1; ++t)
+                            yi[t] += a * xj[t];
+                    }
+                }
+            }
+        }, std::max<size_t>(1, PARALLEL_MIN_CHUNK / std::max<size_t>(k, 1)));
+    }
+    // строка i результата - сумма строк this с весами из строки i X
+    template<typename Policy, typename X, typename Y>
+    void multiplyBlockLeft(const Policy& policy, size_t m, X xrow, Y yrow) const
+    {
+        size_t work = values.size() + nRows;
+        ForEachChunk(policy, m, std::max<size_t>(1, PARALLEL_MIN_CHUNK / work), [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                const T* xi = xrow(i);
+                T* yi = yrow(i);
+                std::fill(yi, yi + nCols, T());
+                for (size_t j = 0; j < nRows; ++j)
+                {
+                    const T a = xi[j];
+                    if (a == T())
+                        continue;
+                    for (size_t p = rowPtr[j]; p < rowPtr[j + 1]; ++p)
+                        yi[colInd[p]] += a * values[p];
+                }
+            }
+        });
+    }
+
+    // y[i] = (строка i) * x; куски строк выбираются по числу ненулевых,
+    // а не строк, чтобы длинные строки не собирались в одной задаче.
+    // Каждая строка суммируется одним потоком в одном порядке, поэтому
+    // результат не зависит ни от политики, ни от числа потоков
+    template<typename Policy>
+    void multiplyRows(const Policy& policy, const T* x, T* y) const
+    {
+        const size_t* rp = rowPtr.data();
+        const Index* ci = colInd.data();
+        const T* va = values.data();
+        ForEachWeightedChunk(policy, nRows, rp, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                // четыре независимые суммы: цепочка зависимостей короче,
+                // и компилятор может векторизовать сбор x[ci[k]]
+                T s0{}, s1{}, s2{}, s3{};
+                size_t k = rp[i], ke = rp[i + 1];
+                for (; k + 4 <= ke; k += 4)
+                {
+                    s0 += va[k] * x[ci[k]];
+                    s1 += va[k + 1] * x[ci[k + 1]];
+                    s2 += va[k + 2] * x[ci[k + 2]];
+                    s3 += va[k + 3] * x[ci[k + 3]];
+                }
+                for (; k < ke; ++k)
+                    s0 += va[k] * x[ci[k]];
+                y[i] = (s0 + s1) + (s2 + s3);
+            }
+        });
+    }
+};
+
+// Разреженная матрица в формате CSC (сжатые столбцы) - для доступа
+// по столбцам. Хранится как CSR транспонированной матрицы: ненулевые
+// элементы столбца j - values[colPtr[j], colPtr[j + 1]) по возрастанию
+// номеров строк rowInd
+template<typename T>
+class TCSCMatrix
+{
+public:
+    using Index = typename TCSRMatrix<T>::Index;
+
+    TCSCMatrix(size_t rows, size_t cols) : t(cols, rows) {}
+    // из готовых массивов CSC (проверяются)
+    TCSCMatrix(size_t rows, size_t cols, std::vector<size_t> colPtr, std::vector<Index> rowInd, std::vector<T> values)
+        : t(cols, rows, std::move(colPtr), std::move(rowInd), std::move(values))
+    {
+    }
+    // из CSR - транспонирование массивов
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TCSCMatrix(const Policy& policy, const TCSRMatrix<T>& m) : t(m.Transpose(policy)) {}
+    explicit TCSCMatrix(const TCSRMatrix<T>& m) : TCSCMatrix(exec_par, m) {}
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TCSCMatrix(const Policy& policy, const TDynamicMatrix<T>& m) : t(TCSRMatrix<T>(policy, m).Transpose(policy)) {}
+    explicit TCSCMatrix(const TDynamicMatrix<T>& m) : TCSCMatrix(exec_par, m) {}
+
+    size_t GetRows() const noexcept { return t.nCols; }
+    size_t GetCols() const noexcept { return t.nRows; }
+    size_t GetNonZeros() const noexcept { return t.values.size(); }
+
+    const std::vector<size_t>& ColPtr() const noexcept { return t.rowPtr; }
+    const std::vector<Index>& RowIndices() const noexcept { return t.colInd; }
+    const std::vector<T>& Values() const noexcept { return t.values; }
+
+    T operator()(size_t i, size_t j) const
+    {
+        if (i >= GetRows() || j >= GetCols())
+            throw out_of_range("Index out of range");
+
+        return t(j, i);
+    }
+
+    bool operator==(const TCSCMatrix& m) const noexcept
+    {
+        return t == m.t;
+    }
+    bool operator!=(const TCSCMatrix& m) const noexcept
+    {
+        return t != m.t;
+    }
+
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TCSRMatrix<T> ToCSR(const Policy& policy) const
+    {
+        return t.Transpose(policy);
+    }
+    TCSRMatrix<T> ToCSR() const
+    {
+        return ToCSR(exec_par);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicMatrix<T> ToDense(const Policy& policy) const
+    {
+        return ToCSR(policy).ToDense(policy);
+    }
+    TDynamicMatrix<T> ToDense() const
+    {
+        return ToDense(exec_par);
+    }
+
+private:
+    template<typename> friend class TCOOBuilder;
+
+    TCSRMatrix<T> t; // транспонированная матрица в CSR
+
+    struct TFromTransposed {};
+    TCSCMatrix(TCSRMatrix<T> transposed, TFromTransposed) : t(std::move(transposed)) {}
+};
+
+// Построитель разреженной матрицы из троек (i, j, значение) в любом порядке;
+// повторяющиеся позиции при сжатии в CSR/CSC суммируются (в порядке
+// добавления, поэтому результат не зависит от числа потоков)
+template<typename T>
+class TCOOBuilder
+{
+public:
+    using Index = typename TCSRMatrix<T>::Index;
+
+    TCOOBuilder(size_t rows, size_t cols) : nRows(rows), nCols(cols)
+    {
+        TCSRMatrix<T>::checkSize(rows, cols);
+    }
+
+    size_t GetRows() const noexcept { return nRows; }
+    size_t GetCols() const noexcept { return nCols; }
+    // число добавленных троек (с повторами)
+    size_t GetCount() const noexcept { return values.size(); }
+
+    void Reserve(size_t count)
+    {
+        rowInd.reserve(count);
+        colInd.reserve(count);
+        values.reserve(count);
+    }
+    void Add(size_t i, size_t j, const T& value)
+    {
+        if (i >= nRows || j >= nCols)
+            throw out_of_range("Index out of range");
+
+        rowInd.push_back(static_cast<Index>(i));
+        colInd.push_back(static_cast<Index>(j));
+        values.push_back(value);
+    }
+    void Clear() noexcept
+    {
+        rowInd.clear();
+        colInd.clear();
+        values.clear();
+    }
+
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TCSRMatrix<T> ToCSR(const Policy& policy) const
+    {
+        return compress(policy, rowInd, colInd, nRows, nCols);
+    }
+    TCSRMatrix<T> ToCSR() const
+    {
+        return ToCSR(exec_par);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TCSCMatrix<T> ToCSC(const Policy& policy) const
+    {
+        return TCSCMatrix<T>(compress(policy, colInd, rowInd, nCols, nRows), typename TCSCMatrix<T>::TFromTransposed{});
+    }
+    TCSCMatrix<T> ToCSC() const
+    {
+        return ToCSC(exec_par);
+    }
+
+private:
+    size_t nRows, nCols;
+    std::vector<Index> rowInd, colInd;
+    std::vector<T> values;
+
+    // CSR по главным индексам major (строки для CSR, столбцы для CSC):
+    // сортировка подсчётом по major, сортировка каждой строки по (minor,
+    // номер тройки), подсчёт различных minor, префиксные суммы, слияние
+    template<typename Policy>
+    TCSRMatrix<T> compress(const Policy& policy, const std::vector<Index>& major, const std::vector<Index>& minor,
+                           size_t nMajor, size_t nMinor) const
+    {
+        size_t n = values.size();
+        std::vector<size_t> ptr, perm;
+        CountingSort(policy, n, nMajor, [&major](size_t t) { return major[t]; }, ptr, perm);
+
+        size_t grain = std::max<size_t>(1, PARALLEL_MIN_CHUNK * nMajor / std::max<size_t>(n, 1));
+        std::vector<size_t> resultPtr(nMajor + 1);
+        ForEachChunk(policy, nMajor, grain, [&](size_t first, size_t last) {
+            auto byMinor = [&minor](size_t a, size_t b) { return minor[a] < minor[b] || (minor[a] == minor[b] && a < b); };
+            for (size_t i = first; i < last; ++i)
+            {
+                auto b = perm.begin() + ptr[i], e = perm.begin() + ptr[i + 1];
+                // тройки строки уже идут по номеру; часто и по minor
+                if (!std::is_sorted(b, e, byMinor))
+                    std::sort(b, e, byMinor);
+                size_t count = 0;
+                for (auto it = b; it != e; ++it)
+                    count += it == b || minor[*it] != minor[*(it - 1)];
+                resultPtr[i] = count;
+            }
+        });
+        size_t nnz = ScanChunks(policy, resultPtr.data(), resultPtr.data(), nMajor, size_t(0), false);
+        resultPtr[nMajor] = nnz;
+
+        std::vector<Index> ind(nnz);
+        std::vector<T> val(nnz);
+        ForEachChunk(policy, nMajor, grain, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                size_t q = resultPtr[i];
+                for (size_t p = ptr[i]; p < ptr[i + 1]; ++p)
+                {
+                    size_t t = perm[p];
+                    if (p == ptr[i] || minor[t] != ind[q - 1])
+                    {
+                        ind[q] = minor[t];
+                        val[q++] = values[t];
+                    }
+                    else
+                        val[q - 1] += values[t];
+                }
+            }
+        });
+        return TCSRMatrix<T>(nMajor, nMinor, std::move(resultPtr), std::move(ind), std::move(val),
+                             typename TCSRMatrix<T>::TTrusted{});
+    }
+};
+
+// Произведение плотной матрицы на разреженную (размеры совпадают)
+template<typename T>
+TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& a, const TCSRMatrix<T>& b)
+{
+    return b.multiplyLeft(exec_par, a);
+}
+
+// Произведение разреженных матриц c = a * b по Густавсону в две фазы.
+// Символьная (конструктор) строит структуру c: строка i - объединение
+// строк b по ненулевым a[i][k]. Числовая (Compute) вычисляет значения
+// по готовой структуре и может повторяться для любых a и b с той же
+// структурой (например, при меняющихся коэффициентах на итерациях).
+// Строки распределяются по потокам по числу умножений, каждая строка
+// считается одним потоком в одном порядке - результат не зависит
+// от числа потоков.
+template<typename T>
+class TSparseProduct
+{
+public:
+    using Index = typename TCSRMatrix<T>::Index;
+
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TSparseProduct(const Policy& policy, const TCSRMatrix<T>& a, const TCSRMatrix<T>& b)
+        : nRows(a.nRows), nInner(a.nCols), nCols(b.nCols), aNonZeros(a.GetNonZeros()), bNonZeros(b.GetNonZeros()),
+          aPattern(patternHash(policy, a)), bPattern(patternHash(policy, b)), work(a.nRows + 1), rowPtr(a.nRows + 1)
+    {
+        if (a.nCols != b.nRows)
+            throw invalid_argument("Matrix dimensions must match for multiplication!");
+
+        // число умножений по строкам - веса для распределения строк
+        size_t grain = std::max<size_t>(1, PARALLEL_MIN_CHUNK * nRows / std::max<size_t>(aNonZeros, 1));
+        ForEachChunk(policy, nRows, grain, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                size_t w = 0;
+                for (size_t k = a.rowPtr[i]; k < a.rowPtr[i + 1]; ++k)
+                    w += b.rowPtr[a.colInd[k] + 1] - b.rowPtr[a.colInd[k]];
+                work[i] = w;
+            }
+        });
+        work[nRows] = ScanChunks(policy, work.data(), work.data(), nRows, size_t(0), false);
+
+        // проход 1: число различных столбцов в строках c
+        ForEachWeightedChunk(policy, nRows, work.data(), [&](size_t first, size_t last) {
+            std::vector<Index>& mark = ThreadMarks<Index>(nCols);
+            std::vector<Index> cols;
+            for (size_t i = first; i < last; ++i)
+            {
+                collect(a, b, i, mark, cols);
+                rowPtr[i] = cols.size();
+            }
+        });
+        rowPtr[nRows] = ScanChunks(policy, rowPtr.data(), rowPtr.data(), nRows, size_t(0), false);
+
+        // проход 2: упорядоченные номера столбцов
+        colInd.resize(rowPtr[nRows]);
+        ForEachWeightedChunk(policy, nRows, work.data(), [&](size_t first, size_t last) {
+            std::vector<Index>& mark = ThreadMarks<Index>(nCols);
+            std::vector<Index> cols;
+            for (size_t i = first; i < last; ++i)
+            {
+                collect(a, b, i, mark, cols);
+                std::sort(cols.begin(), cols.end());
+                std::copy(cols.begin(), cols.end(), colInd.begin() + rowPtr[i]);
+            }
+        });
+    }
+
+    size_t GetRows() const noexcept { return nRows; }
+    size_t GetCols() const noexcept { return nCols; }
+    size_t GetNonZeros() const noexcept { return colInd.size(); }
+
+    // числовая фаза в новую матрицу
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TCSRMatrix<T> Compute(const Policy& policy, const TCSRMatrix<T>& a, const TCSRMatrix<T>& b) const
+    {
+        TCSRMatrix<T> c(nRows, nCols, rowPtr, colInd, std::vector<T>(colInd.size()), typename TCSRMatrix<T>::TTrusted{});
+        Compute(policy, a, b, c);
+        return c;
+    }
+    TCSRMatrix<T> Compute(const TCSRMatrix<T>& a, const TCSRMatrix<T>& b) const
+    {
+        return Compute(exec_par, a, b);
+    }
+    // числовая фаза на месте: c - результат предыдущего Compute этого произведения,
+    // перезаписываются только значения. Структура операндов сверяется
+    // по хешу rowPtr и colInd; если при совпавшем хеше слагаемое всё же
+    // не попадает в структуру c, бросается исключение (значения c тогда
+    // не определены)
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    void Compute(const Policy& policy, const TCSRMatrix<T>& a, const TCSRMatrix<T>& b, TCSRMatrix<T>& c) const
+    {
+        if (a.nRows != nRows || a.nCols != nInner || b.nCols != nCols ||
+            a.GetNonZeros() != aNonZeros || b.GetNonZeros() != bNonZeros ||
+            patternHash(policy, a) != aPattern || patternHash(policy, b) != bPattern)
+            throw invalid_argument("Operands do not match the structure of the product");
+        if (c.nRows != nRows || c.nCols != nCols || c.GetNonZeros() != colInd.size())
+            throw invalid_argument("Result does not match the structure of the product");
+
+        T* out = c.values.data();
+        ForEachWeightedChunk(policy, nRows, work.data(), [&](size_t first, size_t last) {
+            std::vector<Index>& mark = ThreadMarks<Index>(nCols);
+            for (size_t i = first; i < last; ++i)
+            {
+                size_t rs = rowPtr[i], re = rowPtr[i + 1];
+                for (size_t q = rs; q < re; ++q)
+                {
+                    mark[colInd[q]] = static_cast<Index>(q - rs);
+                    out[q] = T();
+                }
+                T* ci = out + rs;
+                bool inPattern = true;
+                for (size_t k = a.rowPtr[i]; k < a.rowPtr[i + 1] && inPattern; ++k)
+                {
+                    const T aik = a.values[k];
+                    size_t row = a.colInd[k];
+                    for (size_t p = b.rowPtr[row], pe = b.rowPtr[row + 1]; p < pe; ++p)
+                    {
+                        Index q = mark[b.colInd[p]];
+                        if (q == none)
+                        {
+                            inPattern = false;
+                            break;
+                        }
+                        ci[q] += aik * b.values[p];
+                    }
+                }
+                for (size_t q = rs; q < re; ++q)
+                    mark[colInd[q]] = none;
+                if (!inPattern)
+                    throw invalid_argument("Operands do not match the structure of the product");
+            }
+        });
+    }
+
+private:
+    static constexpr Index none = static_cast<Index>(-1);
+
+    size_t nRows, nInner, nCols;
+    size_t aNonZeros, bNonZeros;   // для проверки операндов числовой фазы
+    uint64_t aPattern, bPattern;
+    std::vector<size_t> work;      // префиксные суммы числа умножений по строкам
+    std::vector<size_t> rowPtr;
+    std::vector<Index> colInd;
+
+    // хеш структуры - сумма перемешанных пар (позиция, значение) по rowPtr
+    // и colInd: от порядка кусков не зависит, поэтому считается параллельно
+    template<typename Policy>
+    static uint64_t patternHash(const Policy& policy, const TCSRMatrix<T>& m)
+    {
+        return hashRange(policy, m.rowPtr.data(), m.rowPtr.size(), 0) +
+               hashRange(policy, m.colInd.data(), m.colInd.size(), m.rowPtr.size());
+    }
+    template<typename Policy, typename V>
+    static uint64_t hashRange(const Policy& policy, const V* data, size_t n, uint64_t offset)
+    {
+        return ReduceChunks(policy, n, PARALLEL_MIN_CHUNK, uint64_t(0), [=](size_t first, size_t last) {
+            uint64_t h = 0;
+            for (size_t k = first; k < last; ++k)
+                h += mix((offset + k) * 0x9e3779b97f4a7c15ULL ^ static_cast<uint64_t>(data[k]));
+            return h;
+        });
+    }
+    // финальное перемешивание splitmix64
+    static uint64_t mix(uint64_t x) noexcept
+    {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    // различные столбцы строки i произведения (в порядке появления)
+    static void collect(const TCSRMatrix<T>& a, const TCSRMatrix<T>& b, size_t i, std::vector<Index>& mark, std::vector<Index>& cols)
+    {
+        cols.clear();
+        for (size_t k = a.rowPtr[i]; k < a.rowPtr[i + 1]; ++k)
+        {
+            size_t row = a.colInd[k];
+            for (size_t p = b.rowPtr[row], pe = b.rowPtr[row + 1]; p < pe; ++p)
+            {
+                Index j = b.colInd[p];
+                if (mark[j] == none)
+                {
+                    mark[j] = 0;
+                    cols.push_back(j);
+                }
+            }
+        }
+        for (Index j : cols)
+            mark[j] = none;
+    }
+};
+
+// Блочная разреженная матрица (BSR) - CSR из плотных блоков b x b
+// (блоки хранятся по строкам подряд): один индекс столбца на блок вместо
+// b * b, и умножения идут плотными микроядрами с развёрнутыми для
+// b = 2, 3, 4 циклами. Размеры кратны b; нули внутри блоков хранятся явно.
+template<typename T>
+class TBSRMatrix
+{
+public:
+    using Index = typename TCSRMatrix<T>::Index;
+
+    // из CSR с заданным размером блока
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TBSRMatrix(const Policy& policy, const TCSRMatrix<T>& m, size_t blockSize) : nRows(m.nRows), nCols(m.nCols), bs(blockSize)
+    {
+        if (bs == 0)
+            throw invalid_argument("Block size should be greater than zero");
+        if (nRows % bs != 0 || nCols % bs != 0)
+            throw invalid_argument("Matrix size should be a multiple of the block size");
+
+        size_t nbr = nRows / bs, nbc = nCols / bs;
+        // работа блочной строки - ненулевые её строк
+        std::vector<size_t> work(nbr + 1);
+        for (size_t bi = 0; bi <= nbr; ++bi)
+            work[bi] = m.rowPtr[bi * bs];
+
+        blockRowPtr.resize(nbr + 1);
+        ForEachWeightedChunk(policy, nbr, work.data(), [&](size_t first, size_t last) {
+            std::vector<Index>& mark = ThreadMarks<Index>(nbc);
+            std::vector<Index> cols;
+            for (size_t bi = first; bi < last; ++bi)
+            {
+                collect(m, bi, mark, cols);
+                blockRowPtr[bi] = cols.size();
+            }
+        });
+        blockRowPtr[nbr] = ScanChunks(policy, blockRowPtr.data(), blockRowPtr.data(), nbr, size_t(0), false);
+
+        blockColInd.resize(blockRowPtr[nbr]);
+        values.resize(blockRowPtr[nbr] * bs * bs);
+        ForEachWeightedChunk(policy, nbr, work.data(), [&](size_t first, size_t last) {
+            std::vector<Index>& mark = ThreadMarks<Index>(nbc);
+            std::vector<Index> cols;
+            for (size_t bi = first; bi < last; ++bi)
+            {
+                collect(m, bi, mark, cols);
+                std::sort(cols.begin(), cols.end());
+                size_t rs = blockRowPtr[bi];
+                for (size_t q = 0; q < cols.size(); ++q)
+                {
+                    blockColInd[rs + q] = cols[q];
+                    mark[cols[q]] = static_cast<Index>(q);
+                }
+                for (size_t r = 0; r < bs; ++r)
+                {
+                    size_t i = bi * bs + r;
+                    for (size_t p = m.rowPtr[i]; p < m.rowPtr[i + 1]; ++p)
+                    {
+                        size_t j = m.colInd[p];
+                        values[((rs + mark[j / bs]) * bs + r) * bs + j % bs] = m.values[p];
+                    }
+                }
+                for (Index c : cols)
+                    mark[c] = static_cast<Index>(-1);
+            }
+        });
+    }
+    // из CSR с размером блока DetectBlockSize
+    explicit TBSRMatrix(const TCSRMatrix<T>& m) : TBSRMatrix(exec_par, m, DetectBlockSize(m)) {}
+
+    // Размер блока, при котором умножение читает меньше всего памяти:
+    // для b из 2..6, на которые делятся размеры, по выборке блочных строк
+    // оценивается заполнение блоков, и объём значений и индексов на
+    // ненулевой элемент сравнивается с CSR. 1 - блоки невыгодны
+    static size_t DetectBlockSize(const TCSRMatrix<T>& m)
+    {
+        const size_t candidates[] = { 2, 3, 4, 5, 6 };
+        const size_t maxSample = 4096;
+        size_t best = 1;
+        double bestCost = static_cast<double>(sizeof(T) + sizeof(Index));
+        for (size_t b : candidates)
+        {
+            if (m.nRows % b != 0 || m.nCols % b != 0)
+                continue;
+            size_t nbr = m.nRows / b;
+            size_t step = std::max<size_t>(1, nbr / maxSample);
+            std::vector<Index>& mark = ThreadMarks<Index>(m.nCols / b);
+            std::vector<Index> cols;
+            size_t blocks = 0, nnz = 0;
+            for (size_t bi = 0; bi < nbr; bi += step)
+            {
+                blocks += collect(m, bi, b, mark, cols);
+                nnz += m.rowPtr[(bi + 1) * b] - m.rowPtr[bi * b];
+            }
+            if (nnz == 0)
+                continue;
+            double cost = static_cast<double>(blocks * (b * b * sizeof(T) + sizeof(Index))) / static_cast<double>(nnz);
+            if (cost < bestCost)
+            {
+                best = b;
+                bestCost = cost;
+            }
+        }
+        return best;
+    }
+
+    size_t GetRows() const noexcept { return nRows; }
+    size_t GetCols() const noexcept { return nCols; }
+    size_t GetBlockSize() const noexcept { return bs; }
+    size_t GetBlockCount() const noexcept { return blockColInd.size(); }
+
+    const std::vector<size_t>& BlockRowPtr() const noexcept { return blockRowPtr; }
+    const std::vector<Index>& BlockColIndices() const noexcept { return blockColInd; }
+    const std::vector<T>& Values() const noexcept { return values; }
+
+    T operator()(size_t i, size_t j) const
+    {
+        if (i >= nRows || j >= nCols)
+            throw out_of_range("Index out of range");
+
+        size_t bi = i / bs;
+        auto first = blockColInd.begin() + blockRowPtr[bi], last = blockColInd.begin() + blockRowPtr[bi + 1];
+        auto it = std::lower_bound(first, last, static_cast<Index>(j / bs));
+        if (it == last || *it != j / bs)
+            return T();
+        return values[((it - blockColInd.begin()) * bs + i % bs) * bs + j % bs];
+    }
+
+    // в CSR без нулей, появившихся из-за блоков
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TCSRMatrix<T> ToCSR(const Policy& policy) const
+    {
+        size_t nbr = nRows / bs;
+        std::vector<size_t> rowPtr(nRows + 1);
+        ForEachWeightedChunk(policy, nbr, blockRowPtr.data(), [&](size_t first, size_t last) {
+            for (size_t i = first * bs; i < last * bs; ++i)
+            {
+                size_t bi = i / bs, r = i % bs, count = 0;
+                for (size_t q = blockRowPtr[bi]; q < blockRowPtr[bi + 1]; ++q)
+                    for (size_t c = 0; c < bs; ++c)
+                        count += values[(q * bs + r) * bs + c] != T();
+                rowPtr[i] = count;
+            }
+        });
+        rowPtr[nRows] = ScanChunks(policy, rowPtr.data(), rowPtr.data(), nRows, size_t(0), false);
+
+        std::vector<Index> colInd(rowPtr[nRows]);
+        std::vector<T> val(rowPtr[nRows]);
+        ForEachWeightedChunk(policy, nbr, blockRowPtr.data(), [&](size_t first, size_t last) {
+            for (size_t i = first * bs; i < last * bs; ++i)
+            {
+                size_t bi = i / bs, r = i % bs, p = rowPtr[i];
+                for (size_t q = blockRowPtr[bi]; q < blockRowPtr[bi + 1]; ++q)
+                    for (size_t c = 0; c < bs; ++c)
+                    {
+                        const T& v = values[(q * bs + r) * bs + c];
+                        if (v != T())
+                        {
+                            colInd[p] = static_cast<Index>(blockColInd[q] * bs + c);
+                            val[p++] = v;
+                        }
+                    }
+            }
+        });
+        return TCSRMatrix<T>(nRows, nCols, std::move(rowPtr), std::move(colInd), std::move(val),
+                             typename TCSRMatrix<T>::TTrusted{});
+    }
+    TCSRMatrix<T> ToCSR() const
+    {
+        return ToCSR(exec_par);
+    }
+
+    // SpMV
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const
+    {
+        return multiply(exec_par, v);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicVector<T> multiply(const Policy& policy, const TDynamicVector<T>& v) const
+    {
+        if (v.size() != nCols) throw invalid_argument("Matrix columns and vector size must be equal for multiplication!");
+        TDynamicVector<T> result(nRows);
+        const T* x = v.data();
+        T* y = result.data();
+        dispatch(policy, [&](auto b, size_t first, size_t last) { multiplyRows<decltype(b)::value>(first, last, x, y); });
+        return result;
+    }
+
+    // SpMM, как у TCSRMatrix
+    TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& m) const
+    {
+        return multiply(exec_par, m);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicMatrix<T> multiply(const Policy& policy, const TDynamicMatrix<T>& m) const
+    {
+        size_t n = m.GetSize();
+        if (nRows != n || nCols != n)
+            throw invalid_argument("Matrix dimensions must match for multiplication!");
+
+        TDynamicMatrix<T> result(static_cast<int>(n));
+        std::vector<T*> y(n);
+        for (size_t i = 0; i < n; ++i)
+            y[i] = result[i].data();
+        auto xrow = [&m](size_t j) { return m[j].data(); };
+        auto yrow = [&y](size_t i) { return y[i]; };
+        dispatch(policy, [&](auto b, size_t first, size_t last) { multiplyBlockRows<decltype(b)::value>(first, last, n, xrow, yrow); });
+        return result;
+    }
+    // Y = this * X, X - cols x k, Y - rows x k по строкам подряд
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    void multiply(const Policy& policy, const T* x, size_t k, T* y) const
+    {
+        auto xrow = [x, k](size_t j) { return x + j * k; };
+        auto yrow = [y, k](size_t i) { return y + i * k; };
+        dispatch(policy, [&](auto b, size_t first, size_t last) { multiplyBlockRows<decltype(b)::value>(first, last, k, xrow, yrow); });
+    }
+
+private:
+    size_t nRows, nCols, bs;
+    std::vector<size_t> blockRowPtr;
+    std::vector<Index> blockColInd;
+    std::vector<T> values;
+
+    // различные блочные столбцы блочной строки bi при блоках b x b, их число
+    static size_t collect(const TCSRMatrix<T>& m, size_t bi, size_t b, std::vector<Index>& mark, std::vector<Index>& cols)
+    {
+        cols.clear();
+        for (size_t p = m.rowPtr[bi * b]; p < m.rowPtr[(bi + 1) * b]; ++p)
+        {
+            Index c = static_cast<Index>(m.colInd[p] / b);
+            if (mark[c] == static_cast<Index>(-1))
+            {
+                mark[c] = 0;
+                cols.push_back(c);
+            }
+        }
+        for (Index c : cols)
+            mark[c] = static_cast<Index>(-1);
+        return cols.size();
+    }
+    size_t collect(const TCSRMatrix<T>& m, size_t bi, std::vector<Index>& mark, std::vector<Index>& cols) const
+    {
+        return collect(m, bi, bs, mark, cols);
+    }
+
+    // body(b, first, last) по кускам блочных строк, где b - размер блока
+    // как константа времени компиляции (0 - любой, берётся bs)
+    template<typename Policy, typename F>
+    void dispatch(const Policy& policy, F body) const
+    {
+        ForEachWeightedChunk(policy, nRows / bs, blockRowPtr.data(), [&](size_t first, size_t last) {
+            switch (bs)
+            {
+            case 2: body(std::integral_constant<size_t, 2>{}, first, last); break;
+            case 3: body(std::integral_constant<size_t, 3>{}, first, last); break;
+            case 4: body(std::integral_constant<size_t, 4>{}, first, last); break;
+            default: body(std::integral_constant<size_t, 0>{}, first, last); break;
+            }
+        }, std::max<size_t>(1, PARALLEL_MIN_CHUNK / (bs * bs)));
+    }
+
+    // y = A * x для блочных строк [first, last): блок на отрезок x - плотное
+    // произведение, как в TDynamicMatrix, с накоплением через MultiplyAdd
+    template<size_t B>
+    void multiplyRows(size_t first, size_t last, const T* x, T* y) const
+    {
+        const size_t b = B != 0 ? B : bs;
+        // при известном b сумма строк блока держится в регистрах
+        T fixed[B != 0 ? B : 1];
+        std::vector<T> dynamic(B != 0 ? 0 : b);
+        T* acc = B != 0 ? fixed : dynamic.data();
+        for (size_t bi = first; bi < last; ++bi)
+        {
+            std::fill(acc, acc + b, T());
+            for (size_t q = blockRowPtr[bi]; q < blockRowPtr[bi + 1]; ++q)
+            {
+                const T* blk = values.data() + q * b * b;
+                const T* xj = x + blockColInd[q] * b;
+                for (size_t r = 0; r < b; ++r)
+                    for (size_t c = 0; c < b; ++c)
+                        acc[r] = MultiplyAdd(blk[r * b + c], xj[c], acc[r]);
+            }
+            std::copy(acc, acc + b, y + bi * b);
+        }
+    }
+
+    // Y = A * X для блочных строк [first, last): внутренний цикл по k векторам
+    template<size_t B, typename X, typename Y>
+    void multiplyBlockRows(size_t first, size_t last, size_t k, X xrow, Y yrow) const
+    {
+        const size_t b = B != 0 ? B : bs;
+        for (size_t bi = first; bi < last; ++bi)
+        {
+            for (size_t r = 0; r < b; ++r)
+                std::fill(yrow(bi * b + r), yrow(bi * b + r) + k, T());
+            for (size_t q = blockRowPtr[bi]; q < blockRowPtr[bi + 1]; ++q)
+            {
+                const T* blk = values.data() + q * b * b;
+                for (size_t r = 0; r < b; ++r)
+                {
+                    T* yi = yrow(bi * b + r);
+                    for (size_t c = 0; c < b; ++c)
+                    {
+                        const T a = blk[r * b + c];
+                        const T* xj = xrow(blockColInd[q] * b + c);
+                        for (size_t t = 0; t < k; ++t)
+                            yi[t] += a * xj[t];
+                    }
+                }
+            }
+        }
+    }
+};
+
+#endif
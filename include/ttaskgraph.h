@@ -0,0 +1,288 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Граф задач и поблочные матричные операции
+
+#ifndef __TTaskGraph_H__
+#define __TTaskGraph_H__
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+#include "tmatrix.h"
+
+// Граф задач с зависимостями -
+// задача запускается в пуле потоков, как только выполнены все
+// задачи, от которых она зависит; барьеров между операциями нет.
+// После исключения в задаче оставшиеся задачи не выполняются,
+// а исключение пробрасывается из Run.
+class TTaskGraph
+{
+public:
+    using TaskId = size_t;
+
+    TaskId AddTask(std::function<void()> f, const std::vector<TaskId>& deps = {})
+    {
+        TaskId id = nodes.size();
+        for (TaskId d : deps)
+            if (d >= id)
+                throw invalid_argument("Task can depend only on previously added tasks");
+
+        nodes.push_back(std::make_unique<TNode>());
+        nodes[id]->f = std::move(f);
+        nodes[id]->depCount = deps.size();
+        for (TaskId d : deps)
+            nodes[d]->next.push_back(id);
+        return id;
+    }
+    size_t GetTaskCount() const noexcept
+    {
+        return nodes.size();
+    }
+
+    // Учёт обращений к строкам [first, last) буфера data. Чтение зависит
+    // от последней записи (RAW), запись - ещё и от всех чтений после неё
+    // (WAR) и от самой записи (WAW). Hazards возвращает эти зависимости
+    // для новой задачи, Record отмечает обращение уже добавленной задачи id.
+    std::vector<TaskId> Hazards(const void* data, size_t first, size_t last, bool write) const
+    {
+        std::vector<TaskId> deps;
+        auto it = accesses.find(data);
+        if (it == accesses.end())
+            return deps;
+        const std::vector<TAccess>& rows = it->second;
+        for (size_t i = first; i < std::min(last, rows.size()); ++i)
+        {
+            if (rows[i].writer != noTask)
+                deps.push_back(rows[i].writer);
+            if (write)
+                deps.insert(deps.end(), rows[i].readers.begin(), rows[i].readers.end());
+        }
+        std::sort(deps.begin(), deps.end());
+        deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+        return deps;
+    }
+    void Record(const void* data, size_t first, size_t last, bool write, TaskId id)
+    {
+        if (id >= nodes.size())
+            throw invalid_argument("Unknown task");
+        std::vector<TAccess>& rows = accesses[data];
+        if (rows.size() < last)
+            rows.resize(last);
+        for (size_t i = first; i < last; ++i)
+            if (write)
+            {
+                rows[i].writer = id;
+                rows[i].readers.clear();
+            }
+            else if (rows[i].readers.empty() || rows[i].readers.back() != id)
+                rows[i].readers.push_back(id);
+    }
+
+    // выполнение всех задач; граф можно запускать повторно
+    void Run()
+    {
+        failed = false;
+        for (auto& n : nodes)
+            n->remaining = n->depCount;
+
+        TTaskGroup group;
+        for (TaskId id = 0; id < nodes.size(); ++id)
+            if (nodes[id]->depCount == 0)
+                group.Run([this, &group, id] { execute(group, id); });
+        group.Wait();
+    }
+
+private:
+    struct TNode
+    {
+        std::function<void()> f;
+        std::vector<TaskId> next;
+        size_t depCount = 0;
+        std::atomic<size_t> remaining{ 0 };
+    };
+
+    static constexpr TaskId noTask = static_cast<TaskId>(-1);
+    struct TAccess
+    {
+        TaskId writer = noTask;
+        std::vector<TaskId> readers;
+    };
+
+    std::vector<std::unique_ptr<TNode>> nodes;
+    std::map<const void*, std::vector<TAccess>> accesses;
+    std::atomic<bool> failed{ false };
+
+    void execute(TTaskGroup& group, TaskId id)
+    {
+        // последнюю ставшую готовой задачу выполняем сами, остальные - в пул
+        const TaskId none = nodes.size();
+        while (id != none && !failed)
+        {
+            try
+            {
+                nodes[id]->f();
+            }
+            catch (...)
+            {
+                failed = true;
+                throw;
+            }
+            TaskId last = none;
+            for (TaskId s : nodes[id]->next)
+                if (nodes[s]->remaining.fetch_sub(1) == 1)
+                {
+                    if (last != none)
+                        group.Run([this, &group, last] { execute(group, last); });
+                    last = s;
+                }
+            id = last;
+        }
+    }
+};
+
+// Матрица как операнд графа: блоки по tile строк и задачи,
+// после которых соответствующий блок строк готов (пусто - матрица готова)
+template<typename T>
+class TTiledMatrix
+{
+public:
+    TTiledMatrix(TDynamicMatrix<T>& m, size_t tile) : matrix(&m), tileSize(tile)
+    {
+        if (tile == 0)
+            throw invalid_argument("Tile size should be greater than zero");
+    }
+
+    TDynamicMatrix<T>& Matrix() const noexcept { return *matrix; }
+    size_t GetTileSize() const noexcept { return tileSize; }
+    size_t GetBlockCount() const noexcept { return (matrix->GetSize() + tileSize - 1) / tileSize; }
+    size_t BlockBegin(size_t b) const noexcept { return b * tileSize; }
+    size_t BlockEnd(size_t b) const noexcept { return std::min(matrix->GetSize(), (b + 1) * tileSize); }
+
+    // задачи, от которых зависит готовность блока строк b
+    std::vector<TTaskGraph::TaskId> Dependencies(size_t b) const
+    {
+        if (producers.empty())
+            return {};
+        return { producers[b] };
+    }
+    // задачи, от которых зависит готовность всей матрицы
+    std::vector<TTaskGraph::TaskId> AllDependencies() const
+    {
+        return producers;
+    }
+
+private:
+    template<typename U>
+    friend TTiledMatrix<U> AddProduct(TTaskGraph&, const TTiledMatrix<U>&, const TTiledMatrix<U>&, TDynamicMatrix<U>&);
+    template<typename U>
+    friend TTiledMatrix<U> AddSum(TTaskGraph&, const TTiledMatrix<U>&, const TTiledMatrix<U>&, TDynamicMatrix<U>&);
+
+    TDynamicMatrix<T>* matrix;
+    size_t tileSize;
+    std::vector<TTaskGraph::TaskId> producers;
+};
+
+// c = a * b по блокам tile x tile: блок (i, j) зависит только от блока
+// строк i матрицы a и от всей b, поэтому следующая операция над блоком
+// строк i результата может начаться до завершения остальных блоков.
+// Запись в c ждёт задач графа, которые раньше читали или писали те же
+// строки c (см. TTaskGraph::Hazards), поэтому c можно использовать повторно
+template<typename T>
+TTiledMatrix<T> AddProduct(TTaskGraph& g, const TTiledMatrix<T>& a, const TTiledMatrix<T>& b, TDynamicMatrix<T>& c)
+{
+    size_t n = a.Matrix().GetSize();
+    if (b.Matrix().GetSize() != n || c.GetSize() != n)
+        throw invalid_argument("Matrix dimensions must match for multiplication!");
+
+    if (&c == &a.Matrix() || &c == &b.Matrix())
+        throw invalid_argument("Product result should not alias its operands");
+
+    // копия при записи (SetCopyOnWrite) отделяется здесь, а не в задачах
+    for (size_t i = 0; i < n; ++i)
+        c[i].data();
+
+    TTiledMatrix<T> result(c, a.GetTileSize());
+    std::vector<TTaskGraph::TaskId> all = b.AllDependencies();
+    for (size_t bi = 0; bi < result.GetBlockCount(); ++bi)
+    {
+        size_t r0 = result.BlockBegin(bi), r1 = result.BlockEnd(bi);
+        std::vector<TTaskGraph::TaskId> deps = a.Dependencies(bi);
+        deps.insert(deps.end(), all.begin(), all.end());
+        for (auto hazards : { g.Hazards(&a.Matrix(), r0, r1, false), g.Hazards(&b.Matrix(), 0, n, false),
+            g.Hazards(&c, r0, r1, true) })
+            deps.insert(deps.end(), hazards.begin(), hazards.end());
+
+        std::vector<TTaskGraph::TaskId> tiles;
+        for (size_t c0 = 0; c0 < n; c0 += result.GetTileSize())
+        {
+            size_t c1 = std::min(n, c0 + result.GetTileSize());
+            const TDynamicMatrix<T>* pa = &a.Matrix();
+            const TDynamicMatrix<T>* pb = &b.Matrix();
+            TDynamicMatrix<T>* pc = &c;
+            tiles.push_back(g.AddTask([=] {
+                for (size_t i = r0; i < r1; ++i)
+                    std::fill((*pc)[i].data() + c0, (*pc)[i].data() + c1, T());
+                TDynamicMatrix<T>::MultiplyRows(*pa, *pb, *pc, r0, r1, c0, c1);
+            }, deps));
+        }
+        // пустая задача-соединение: блок строк bi готов
+        TTaskGraph::TaskId join = g.AddTask([] {}, tiles);
+        result.producers.push_back(join);
+        g.Record(&a.Matrix(), r0, r1, false, join);
+        g.Record(&b.Matrix(), 0, n, false, join);
+        g.Record(&c, r0, r1, true, join);
+    }
+    return result;
+}
+
+// c = a + b по блокам строк: блок i зависит только от блоков i операндов
+// (и от прежних обращений к строкам c, как в AddProduct); c может совпадать
+// с операндом - каждая задача читает и пишет одни и те же строки
+template<typename T>
+TTiledMatrix<T> AddSum(TTaskGraph& g, const TTiledMatrix<T>& a, const TTiledMatrix<T>& b, TDynamicMatrix<T>& c)
+{
+    size_t n = a.Matrix().GetSize();
+    if (b.Matrix().GetSize() != n || c.GetSize() != n)
+        throw invalid_argument("Matrices must be of the same size for addition");
+    if (a.GetTileSize() != b.GetTileSize())
+        throw invalid_argument("Operands should have the same tile size");
+
+    for (size_t i = 0; i < n; ++i)
+        c[i].data();
+
+    TTiledMatrix<T> result(c, a.GetTileSize());
+    for (size_t bi = 0; bi < result.GetBlockCount(); ++bi)
+    {
+        size_t r0 = result.BlockBegin(bi), r1 = result.BlockEnd(bi);
+        std::vector<TTaskGraph::TaskId> deps = a.Dependencies(bi);
+        for (auto hazards : { b.Dependencies(bi), g.Hazards(&a.Matrix(), r0, r1, false),
+            g.Hazards(&b.Matrix(), r0, r1, false), g.Hazards(&c, r0, r1, true) })
+            deps.insert(deps.end(), hazards.begin(), hazards.end());
+
+        const TDynamicMatrix<T>* pa = &a.Matrix();
+        const TDynamicMatrix<T>* pb = &b.Matrix();
+        TDynamicMatrix<T>* pc = &c;
+        TTaskGraph::TaskId id = g.AddTask([=] {
+            for (size_t i = r0; i < r1; ++i)
+            {
+                const T* x = (*pa)[i].data();
+                const T* y = (*pb)[i].data();
+                T* z = (*pc)[i].data();
+                for (size_t j = 0; j < n; ++j)
+                    z[j] = x[j] + y[j];
+            }
+        }, deps);
+        result.producers.push_back(id);
+        g.Record(&a.Matrix(), r0, r1, false, id);
+        g.Record(&b.Matrix(), r0, r1, false, id);
+        g.Record(&c, r0, r1, true, id);
+    }
+    return result;
+}
+
+#endif
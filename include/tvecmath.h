@@ -0,0 +1,357 @@
+﻿// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Поэлементные трансцендентные функции над векторами и матрицами
+
+#ifndef __TVecMath_H__
+#define __TVecMath_H__
+
+#if !defined(__cpp_if_constexpr) || !defined(__cpp_fold_expressions)
+#error "tvecmath.h requires C++17"
+#endif
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include "tmatrix.h"
+
+// Точность вычислений:
+//   Precise  - вызовы std::exp, std::log, ... (без векторизации);
+//   Balanced - полиномиальные ядра без ветвлений, погрешность в несколько ulp;
+//   Fast     - ядра меньшей степени, ~1e-8 для double и ~1e-5 для float.
+// Ядра Balanced/Fast записаны так, чтобы цикл векторизовался компилятором;
+// для типов, отличных от float и double, всегда используется Precise.
+enum class TMathAccuracy { Precise, Balanced, Fast };
+
+// функции дороже арифметики, поэтому и куски для потоков меньше
+const size_t MATH_MIN_CHUNK = PARALLEL_MIN_CHUNK / 8;
+
+template<typename T>
+struct TMathTraits
+{
+    static constexpr bool IsFast = false;
+};
+
+template<>
+struct TMathTraits<double>
+{
+    static constexpr bool IsFast = true;
+    using Bits = std::uint64_t;
+    static constexpr int Mantissa = 52;
+    static constexpr int Bias = 1023;
+    static constexpr Bits ExpMask = 0x7ff;
+    static constexpr Bits MantMask = 0x000fffffffffffffULL;
+    static constexpr int SubnormalShift = 54;
+    static constexpr double SubnormalScale = 18014398509481984.0; // 2^54
+    // exp(x) конечна при x <= ln(DBL_MAX) и не меньше половины
+    // наименьшего денормализованного числа при x >= ln(2^-1075)
+    static constexpr double ExpHi = 709.782712893384;
+    static constexpr double ExpLo = -745.1332191019411;
+    static constexpr double Log2e = 1.44269504088896338700e+00;
+    static constexpr double Ln2Hi = 6.93147180369123816490e-01;
+    static constexpr double Ln2Lo = 1.90821492927058770002e-10;
+    static constexpr double Sqrt2 = 1.41421356237309504880;
+    // степени полиномов для Balanced и Fast
+    static constexpr int ExpDegree[2] = { 13, 7 };
+    static constexpr int LogTerms[2] = { 11, 5 };
+};
+
+template<>
+struct TMathTraits<float>
+{
+    static constexpr bool IsFast = true;
+    using Bits = std::uint32_t;
+    static constexpr int Mantissa = 23;
+    static constexpr int Bias = 127;
+    static constexpr Bits ExpMask = 0xff;
+    static constexpr Bits MantMask = 0x007fffff;
+    static constexpr int SubnormalShift = 25;
+    static constexpr float SubnormalScale = 33554432.0f; // 2^25
+    static constexpr float ExpHi = 88.72283905206835f;
+    static constexpr float ExpLo = -103.97207708399179f;
+    static constexpr float Log2e = 1.44269504088896338700f;
+    static constexpr float Ln2Hi = 0.693145751953125f;
+    static constexpr float Ln2Lo = 1.428606765330187045e-06f;
+    static constexpr float Sqrt2 = 1.41421356237309504880f;
+    static constexpr int ExpDegree[2] = { 7, 5 };
+    static constexpr int LogTerms[2] = { 5, 3 };
+};
+
+// Скалярные ядра; вызываются в циклах по массивам и встраиваются в них
+template<typename T>
+struct TMathKernels
+{
+    using Traits = TMathTraits<T>;
+
+    // коэффициенты полиномов как таблицы времени компиляции
+    template<int N>
+    struct TCoeffs { T c[N + 1]; };
+
+    template<int D>
+    static constexpr TCoeffs<D - 1> expCoeffs()
+    {
+        // c[i] = 1 / (i + 1)!
+        TCoeffs<D - 1> t{};
+        T f = T(1);
+        for (int i = 0; i < D; ++i)
+        {
+            f *= T(i + 1);
+            t.c[i] = T(1) / f;
+        }
+        return t;
+    }
+    template<int K>
+    static constexpr TCoeffs<K - 1> logCoeffs()
+    {
+        // c[i] = 1 / (2i + 1)
+        TCoeffs<K - 1> t{};
+        for (int i = 0; i < K; ++i)
+            t.c[i] = T(1) / T(2 * i + 1);
+        return t;
+    }
+
+    // схема Горнера без цикла: c[N] r^N + ... + c[1] r + c[0]
+    template<int N, size_t... I>
+    static T horner(T r, const TCoeffs<N>& t, std::index_sequence<I...>)
+    {
+        T p = T(0);
+        ((p = p * r + t.c[N - I]), ...);
+        return p;
+    }
+    template<int N>
+    static T horner(T r, const TCoeffs<N>& t)
+    {
+        return horner<N>(r, t, std::make_index_sequence<N + 1>());
+    }
+
+    static T fromBits(typename Traits::Bits b)
+    {
+        T v;
+        std::memcpy(&v, &b, sizeof(T));
+        return v;
+    }
+    static typename Traits::Bits toBits(T v)
+    {
+        typename Traits::Bits b;
+        std::memcpy(&b, &v, sizeof(T));
+        return b;
+    }
+
+    // c ? a : b через битовые маски: GCC (-ftrapping-math) не превращает
+    // условные выражения с плавающей точкой в векторный выбор
+    static T blend(bool c, T a, T b)
+    {
+        typename Traits::Bits m = typename Traits::Bits(0) - static_cast<typename Traits::Bits>(c);
+        return fromBits((toBits(a) & m) | (toBits(b) & ~m));
+    }
+
+    // exp(x) или exp(x) - 1: x = n ln2 + r, |r| <= ln2 / 2,
+    // exp(x) = 2^n (1 + p(r)), p - отрезок ряда Тейлора степени D.
+    // Округление n сделано через сдвиг 1.5 * 2^Mantissa, без преобразований
+    // в целые, которые мешают векторизации (поэтому ядра нельзя
+    // компилировать с -ffast-math). У краёв диапазона 2^n не представимо,
+    // поэтому умножение идёт в два шага: 2^n1 * 2^n2, n1 = n / 2 -
+    // так получаются и числа у DBL_MAX, и денормализованные результаты.
+    template<int D, bool Minus1>
+    static T expImpl(T x)
+    {
+        using Bits = typename Traits::Bits;
+        using SBits = std::make_signed_t<Bits>;
+        static constexpr TCoeffs<D - 1> coeffs = expCoeffs<D>();
+        const T shifter = fromBits(static_cast<Bits>(Traits::Bias + Traits::Mantissa) << Traits::Mantissa
+            | (Bits(1) << (Traits::Mantissa - 1)));
+
+        T xc = blend(x < Traits::ExpLo, Traits::ExpLo, x);
+        xc = blend(xc > Traits::ExpHi, Traits::ExpHi, xc);
+        T t = xc * Traits::Log2e + shifter;
+        T nf = t - shifter;
+        T r = (xc - nf * Traits::Ln2Hi) - nf * Traits::Ln2Lo;
+        // в младших битах t лежит n
+        SBits n = static_cast<SBits>(toBits(t) - toBits(shifter));
+        SBits n1 = n / 2;
+        T scale1 = fromBits(static_cast<Bits>(n1 + Traits::Bias) << Traits::Mantissa);
+        T scale2 = fromBits(static_cast<Bits>(n - n1 + Traits::Bias) << Traits::Mantissa);
+        // p = exp(r) - 1 = r (1 + r/2! + ... + r^(D-1)/D!)
+        T p = r * horner<D - 1>(r, coeffs);
+
+        T res = (scale1 * (T(1) + p)) * scale2;
+        if (Minus1)
+        {
+            // при малых |x| вычитание единицы до умножения на p сохраняет точность;
+            // 2^n переполняется только там, где единица уже не важна
+            T scale = scale1 * scale2;
+            bool big = nf > T(Traits::Mantissa + 2);
+            res = blend(big, res - T(1), (scale - T(1)) + scale * p);
+        }
+        res = blend(x > Traits::ExpHi, std::numeric_limits<T>::infinity(), res);
+        res = blend(x < Traits::ExpLo, Minus1 ? T(-1) : T(0), res);
+        return blend(x != x, x, res);
+    }
+
+    // log(x): x = m 2^e, sqrt(1/2) <= m < sqrt(2),
+    // log(m) = 2 atanh(s), s = (m - 1) / (m + 1), ряд из K членов
+    template<int K>
+    static T logImpl(T x)
+    {
+        using Bits = typename Traits::Bits;
+        static constexpr TCoeffs<K - 1> coeffs = logCoeffs<K>();
+        const Bits two52 = static_cast<Bits>(Traits::Bias + Traits::Mantissa) << Traits::Mantissa;
+
+        bool sub = x < std::numeric_limits<T>::min();
+        Bits b = toBits(x * blend(sub, Traits::SubnormalScale, T(1)));
+        // показатель как число с плавающей точкой: (2^Mantissa + E) - 2^Mantissa
+        T ef = fromBits(two52 | ((b >> Traits::Mantissa) & Traits::ExpMask)) - fromBits(two52);
+        T m = fromBits((b & Traits::MantMask) | (static_cast<Bits>(Traits::Bias) << Traits::Mantissa));
+        bool big = m > Traits::Sqrt2;
+        m = m * blend(big, T(0.5), T(1));
+        ef = ef - T(Traits::Bias) - blend(sub, T(Traits::SubnormalShift), T(0)) + blend(big, T(1), T(0));
+
+        T f = m - T(1);
+        T s = f / (T(2) + f);
+        T q = horner<K - 1>(s * s, coeffs);
+        T res = ef * Traits::Ln2Hi + (T(2) * s * q + ef * Traits::Ln2Lo);
+
+        res = blend(x == std::numeric_limits<T>::infinity(), x, res);
+        res = blend(x == T(0), -std::numeric_limits<T>::infinity(), res);
+        res = blend(x < T(0), std::numeric_limits<T>::quiet_NaN(), res);
+        return blend(x != x, x, res);
+    }
+
+    // tanh(x) = -expm1(-2|x|) / (2 + expm1(-2|x|)) без потери точности у нуля
+    template<int D>
+    static T tanhImpl(T x)
+    {
+        T ax = blend(x < T(0), -x, x);
+        T em = expImpl<D, true>(T(-2) * ax);
+        T t = -em / (T(2) + em);
+        return blend(x < T(0), -t, t);
+    }
+
+    template<int D>
+    static T sigmoidImpl(T x)
+    {
+        return T(1) / (T(1) + expImpl<D, false>(-x));
+    }
+
+    template<typename F>
+    static void loop(const T* x, T* r, size_t n, F f)
+    {
+        for (size_t i = 0; i < n; ++i)
+            r[i] = f(x[i]);
+    }
+
+    static void exp(const T* x, T* r, size_t n, TMathAccuracy acc)
+    {
+        if constexpr (Traits::IsFast)
+        {
+            if (acc == TMathAccuracy::Balanced)
+                return loop(x, r, n, [](T a) { return expImpl<Traits::ExpDegree[0], false>(a); });
+            if (acc == TMathAccuracy::Fast)
+                return loop(x, r, n, [](T a) { return expImpl<Traits::ExpDegree[1], false>(a); });
+        }
+        loop(x, r, n, [](T a) { return static_cast<T>(std::exp(a)); });
+    }
+    static void log(const T* x, T* r, size_t n, TMathAccuracy acc)
+    {
+        if constexpr (Traits::IsFast)
+        {
+            if (acc == TMathAccuracy::Balanced)
+                return loop(x, r, n, [](T a) { return logImpl<Traits::LogTerms[0]>(a); });
+            if (acc == TMathAccuracy::Fast)
+                return loop(x, r, n, [](T a) { return logImpl<Traits::LogTerms[1]>(a); });
+        }
+        loop(x, r, n, [](T a) { return static_cast<T>(std::log(a)); });
+    }
+    // аппаратный sqrt уже корректно округлён, приближения не нужны
+    static void sqrt(const T* x, T* r, size_t n, TMathAccuracy)
+    {
+        loop(x, r, n, [](T a) { return static_cast<T>(std::sqrt(a)); });
+    }
+    static void tanh(const T* x, T* r, size_t n, TMathAccuracy acc)
+    {
+        if constexpr (Traits::IsFast)
+        {
+            if (acc == TMathAccuracy::Balanced)
+                return loop(x, r, n, [](T a) { return tanhImpl<Traits::ExpDegree[0]>(a); });
+            if (acc == TMathAccuracy::Fast)
+                return loop(x, r, n, [](T a) { return tanhImpl<Traits::ExpDegree[1]>(a); });
+        }
+        loop(x, r, n, [](T a) { return static_cast<T>(std::tanh(a)); });
+    }
+    static void sigmoid(const T* x, T* r, size_t n, TMathAccuracy acc)
+    {
+        if constexpr (Traits::IsFast)
+        {
+            if (acc == TMathAccuracy::Balanced)
+                return loop(x, r, n, [](T a) { return sigmoidImpl<Traits::ExpDegree[0]>(a); });
+            if (acc == TMathAccuracy::Fast)
+                return loop(x, r, n, [](T a) { return sigmoidImpl<Traits::ExpDegree[1]>(a); });
+        }
+        loop(x, r, n, [](T a) { return static_cast<T>(T(1) / (T(1) + std::exp(-a))); });
+    }
+};
+
+// Применение ядра kernel(x, r, n) ко всему вектору или матрице
+template<typename Policy, typename T, typename Kernel>
+TDynamicVector<T> MathMap(const Policy& policy, const TDynamicVector<T>& v, Kernel kernel)
+{
+    TDynamicVector<T> result(v.size());
+    const T* x = v.data();
+    T* r = result.data();
+    ForEachChunk(policy, v.size(), MATH_MIN_CHUNK, [=](size_t first, size_t last) {
+        kernel(x + first, r + first, last - first);
+    });
+    return result;
+}
+template<typename Policy, typename T, typename Kernel>
+TDynamicMatrix<T> MathMap(const Policy& policy, const TDynamicMatrix<T>& m, Kernel kernel)
+{
+    size_t n = m.GetSize();
+    TDynamicMatrix<T> result(static_cast<int>(n));
+    size_t grain = n == 0 ? 1 : std::max<size_t>(1, MATH_MIN_CHUNK / n);
+    ForEachChunk(policy, n, grain, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            kernel(m[i].data(), result[i].data(), n);
+    });
+    return result;
+}
+
+#define TVECMATH_FUNCTION(Name, kernelName)                                                           \
+template<typename Policy, typename T, enable_if_exec_policy_t<Policy> = 0>                            \
+TDynamicVector<T> Name(const Policy& policy, const TDynamicVector<T>& v,                              \
+                       TMathAccuracy acc = TMathAccuracy::Balanced)                                   \
+{                                                                                                     \
+    return MathMap(policy, v, [acc](const T* x, T* r, size_t n) { TMathKernels<T>::kernelName(x, r, n, acc); }); \
+}                                                                                                     \
+template<typename Policy, typename T, enable_if_exec_policy_t<Policy> = 0>                            \
+TDynamicMatrix<T> Name(const Policy& policy, const TDynamicMatrix<T>& m,                              \
+                       TMathAccuracy acc = TMathAccuracy::Balanced)                                   \
+{                                                                                                     \
+    return MathMap(policy, m, [acc](const T* x, T* r, size_t n) { TMathKernels<T>::kernelName(x, r, n, acc); }); \
+}                                                                                                     \
+template<typename T>                                                                                  \
+TDynamicVector<T> Name(const TDynamicVector<T>& v, TMathAccuracy acc = TMathAccuracy::Balanced)       \
+{                                                                                                     \
+    return Name(exec_seq, v, acc);                                                                    \
+}                                                                                                     \
+template<typename T>                                                                                  \
+TDynamicMatrix<T> Name(const TDynamicMatrix<T>& m, TMathAccuracy acc = TMathAccuracy::Balanced)       \
+{                                                                                                     \
+    return Name(exec_seq, m, acc);                                                                    \
+}
+
+// Exp, Log, Sqrt, Tanh, Sigmoid для векторов и матриц,
+// с политикой выполнения первым аргументом или без неё
+TVECMATH_FUNCTION(Exp, exp)
+TVECMATH_FUNCTION(Log, log)
+TVECMATH_FUNCTION(Sqrt, sqrt)
+TVECMATH_FUNCTION(Tanh, tanh)
+TVECMATH_FUNCTION(Sigmoid, sigmoid)
+
+#undef TVECMATH_FUNCTION
+
+#endif
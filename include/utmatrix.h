@@ -0,0 +1,452 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Верхнетреугольная и симметричная матрицы
+
+#ifndef __UTMatrix_H__
+#define __UTMatrix_H__
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "tmatrix.h"
+
+// число векторов-накопителей SYMV при exec_par_det (не зависит от числа потоков)
+const size_t SYMV_DET_ACCUMULATORS = 8;
+
+// Верхнетреугольная матрица -
+// хранится только верхний треугольник, n(n+1)/2 элементов подряд по
+// строкам: строка i (элементы i..n-1) начинается с i * n - i * (i - 1) / 2.
+// Каждая строка непрерывна, поэтому сложение и умножение на скаляр -
+// один проход по массиву, а произведения идут по строкам подряд, как
+// в TDynamicMatrix; куски строк для потоков выбираются по объёму работы.
+template<typename T>
+class TUpperTriangularMatrix
+{
+public:
+    TUpperTriangularMatrix(size_t n = 1) : sz(n), elems(checkSize(n) * (n + 1) / 2) {}
+    // верхний треугольник плотной матрицы; ненулевой элемент под диагональю - ошибка
+    explicit TUpperTriangularMatrix(const TDynamicMatrix<T>& m) : TUpperTriangularMatrix(m.GetSize())
+    {
+        T* a = elems.data();
+        for (size_t i = 0; i < sz; ++i)
+        {
+            const T* r = m[i].data();
+            for (size_t j = 0; j < i; ++j)
+                if (r[j] != T())
+                    throw invalid_argument("Matrix has non-zero elements below the diagonal");
+            std::copy(r + i, r + sz, a + start(i));
+        }
+    }
+
+    size_t GetSize() const noexcept { return sz; }
+
+    // элементы треугольника; под диагональю доступны только для чтения (нули)
+    T& operator()(size_t i, size_t j)
+    {
+        if (i >= sz || j >= sz)
+            throw out_of_range("Index out of range");
+        if (j < i)
+            throw out_of_range("Element is below the diagonal");
+
+        return elems[start(i) + j - i];
+    }
+    T operator()(size_t i, size_t j) const
+    {
+        if (i >= sz || j >= sz)
+            throw out_of_range("Index out of range");
+
+        return j < i ? T() : elems[start(i) + j - i];
+    }
+
+    bool operator==(const TUpperTriangularMatrix& m) const noexcept
+    {
+        return sz == m.sz && elems == m.elems;
+    }
+    bool operator!=(const TUpperTriangularMatrix& m) const noexcept
+    {
+        return !(*this == m);
+    }
+
+    TDynamicMatrix<T> ToDense() const
+    {
+        TDynamicMatrix<T> result(static_cast<int>(sz));
+        const T* a = elems.data();
+        for (size_t i = 0; i < sz; ++i)
+            std::copy(a + start(i), a + start(i) + sz - i, result[i].data() + i);
+        return result;
+    }
+
+    // матрично-скалярные операции
+    TUpperTriangularMatrix operator*(const T& val) const
+    {
+        return multiply(exec_par, val);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TUpperTriangularMatrix multiply(const Policy& policy, const T& val) const
+    {
+        return TUpperTriangularMatrix(sz, elems.multiply(policy, val));
+    }
+
+    // матрично-векторные операции
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const
+    {
+        return multiply(exec_par, v);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicVector<T> multiply(const Policy& policy, const TDynamicVector<T>& v) const
+    {
+        if (v.size() != sz) throw invalid_argument("Matrix columns and vector size must be equal for multiplication!");
+        TDynamicVector<T> result(sz);
+        const T* a = elems.data();
+        const T* x = v.data();
+        T* y = result.data();
+        std::vector<size_t> work = rowWork(1);
+        ForEachWeightedChunk(policy, sz, work.data(), [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+            {
+                const T* ai = a + start(i);
+                T s{};
+                for (size_t j = 0; j < sz - i; ++j)
+                    s += ai[j] * x[i + j];
+                y[i] = s;
+            }
+        });
+        return result;
+    }
+
+    // матрично-матричные операции
+    TUpperTriangularMatrix operator+(const TUpperTriangularMatrix& m) const
+    {
+        return add(exec_par, m);
+    }
+    TUpperTriangularMatrix operator-(const TUpperTriangularMatrix& m) const
+    {
+        return subtract(exec_par, m);
+    }
+    TUpperTriangularMatrix operator*(const TUpperTriangularMatrix& m) const
+    {
+        return multiply(exec_par, m);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TUpperTriangularMatrix add(const Policy& policy, const TUpperTriangularMatrix& m) const
+    {
+        if (sz != m.sz) throw invalid_argument("Matrices must be of the same size for addition");
+        return TUpperTriangularMatrix(sz, elems.add(policy, m.elems));
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TUpperTriangularMatrix subtract(const Policy& policy, const TUpperTriangularMatrix& m) const
+    {
+        if (sz != m.sz) throw invalid_argument("Matrices must be of the same size for subtraction");
+        return TUpperTriangularMatrix(sz, elems.subtract(policy, m.elems));
+    }
+    // произведение верхнетреугольных - верхнетреугольная:
+    // c[i][j] = sum(a[i][k] * b[k][j], i <= k <= j), порядок i-k-j по строкам
+    // подряд, как в TDynamicMatrix, но без нулевых половин (в 6 раз меньше
+    // умножений, чем у плотного произведения)
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TUpperTriangularMatrix multiply(const Policy& policy, const TUpperTriangularMatrix& m) const
+    {
+        if (sz != m.sz) throw invalid_argument("Matrix dimensions must match for multiplication!");
+        TUpperTriangularMatrix result(sz);
+        const T* a = elems.data();
+        const T* b = m.elems.data();
+        T* c = result.elems.data();
+        std::vector<size_t> work = rowWork(2);
+        ForEachWeightedChunk(policy, sz, work.data(), [&](size_t first, size_t last) {
+            // строки обрабатываются полосами: строка b читается из памяти
+            // один раз на полосу, а не на каждую строку результата
+            const size_t panel = 4;
+            for (size_t i0 = first; i0 < last; i0 += panel)
+            {
+                size_t i1 = std::min(last, i0 + panel);
+                for (size_t k = i0; k < sz; ++k)
+                {
+                    const T* bk = b + start(k) - k;   // bk[j] - элемент (k, j)
+                    for (size_t i = i0; i < i1 && i <= k; ++i)
+                    {
+                        const T aik = a[start(i) + k - i];
+                        T* ci = c + start(i) - i;
+                        for (size_t j = k; j < sz; ++j)
+                            ci[j] += aik * bk[j];
+                    }
+                }
+            }
+        });
+        return result;
+    }
+
+    // решение this * x = b обратной подстановкой, O(n^2)
+    TDynamicVector<T> Solve(const TDynamicVector<T>& b) const
+    {
+        if (b.size() != sz) throw invalid_argument("Matrix size and right-hand side size must be equal for solving");
+
+        TDynamicVector<T> x(b);
+        T* xs = x.data();
+        const T* a = elems.data();
+        for (size_t i = sz; i-- > 0;)
+        {
+            const T* ai = a + start(i) - i;
+            if (ai[i] == T(0))
+                throw runtime_error("Matrix is singular");
+            T s = xs[i];
+            for (size_t j = i + 1; j < sz; ++j)
+                s -= ai[j] * xs[j];
+            xs[i] = s / ai[i];
+        }
+        return x;
+    }
+
+private:
+    size_t sz;
+    TDynamicVector<T> elems;
+
+    TUpperTriangularMatrix(size_t n, TDynamicVector<T>&& e) : sz(n), elems(std::move(e)) {}
+
+    static size_t checkSize(size_t n)
+    {
+        if (n == 0)
+            throw out_of_range("Matrix size should be greater than zero");
+        if (n > MAX_MATRIX_SIZE)
+            throw out_of_range("Matrix size shouldn't be more than MAX_MATRIX_SIZE");
+        return n;
+    }
+
+    size_t start(size_t i) const noexcept { return i * sz - i * (i - 1) / 2; }
+
+    // префиксные суммы работы по строкам (см. ForEachWeightedChunk): строка i
+    // произведения на вектор - n - i умножений, на треугольную - (n - i)(n - i + 1) / 2
+    std::vector<size_t> rowWork(int degree) const
+    {
+        std::vector<size_t> work(sz + 1, 0);
+        for (size_t i = 0; i < sz; ++i)
+        {
+            size_t len = sz - i;
+            work[i + 1] = work[i] + (degree == 1 ? len : len * (len + 1) / 2);
+        }
+        return work;
+    }
+};
+
+// Симметричная матрица -
+// хранится верхний треугольник в той же упаковке по строкам, что и у
+// TUpperTriangularMatrix (вдвое меньше памяти, чем у TDynamicMatrix).
+// Произведения читают каждый хранимый элемент один раз и используют
+// его дважды: a[i][j] умножается и на x[j] (для y[i]), и на x[i] (для y[j]).
+template<typename T>
+class TSymmetricMatrix
+{
+public:
+    TSymmetricMatrix(size_t n = 1) : sz(n), elems(checkSize(n) * (n + 1) / 2) {}
+    // из плотной матрицы; несимметричная - ошибка
+    explicit TSymmetricMatrix(const TDynamicMatrix<T>& m) : TSymmetricMatrix(m.GetSize())
+    {
+        T* a = elems.data();
+        for (size_t i = 0; i < sz; ++i)
+        {
+            const T* r = m[i].data();
+            for (size_t j = 0; j < i; ++j)
+                if (r[j] != m[j][i])
+                    throw invalid_argument("Matrix is not symmetric");
+            std::copy(r + i, r + sz, a + start(i));
+        }
+    }
+
+    size_t GetSize() const noexcept { return sz; }
+
+    // (i, j) и (j, i) - один и тот же элемент
+    T& operator()(size_t i, size_t j)
+    {
+        if (i >= sz || j >= sz)
+            throw out_of_range("Index out of range");
+
+        return i <= j ? elems[start(i) + j - i] : elems[start(j) + i - j];
+    }
+    const T& operator()(size_t i, size_t j) const
+    {
+        if (i >= sz || j >= sz)
+            throw out_of_range("Index out of range");
+
+        return i <= j ? elems[start(i) + j - i] : elems[start(j) + i - j];
+    }
+
+    bool operator==(const TSymmetricMatrix& m) const noexcept
+    {
+        return sz == m.sz && elems == m.elems;
+    }
+    bool operator!=(const TSymmetricMatrix& m) const noexcept
+    {
+        return !(*this == m);
+    }
+
+    TDynamicMatrix<T> ToDense() const
+    {
+        TDynamicMatrix<T> result(static_cast<int>(sz));
+        const T* a = elems.data();
+        for (size_t i = 0; i < sz; ++i)
+        {
+            const T* ai = a + start(i) - i;
+            T* ri = result[i].data();
+            for (size_t j = i; j < sz; ++j)
+            {
+                ri[j] = ai[j];
+                result[j].data()[i] = ai[j];
+            }
+        }
+        return result;
+    }
+
+    TSymmetricMatrix operator+(const TSymmetricMatrix& m) const
+    {
+        return add(exec_par, m);
+    }
+    TSymmetricMatrix operator-(const TSymmetricMatrix& m) const
+    {
+        return subtract(exec_par, m);
+    }
+    TSymmetricMatrix operator*(const T& val) const
+    {
+        return multiply(exec_par, val);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TSymmetricMatrix add(const Policy& policy, const TSymmetricMatrix& m) const
+    {
+        if (sz != m.sz) throw invalid_argument("Matrices must be of the same size for addition");
+        return TSymmetricMatrix(sz, elems.add(policy, m.elems));
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TSymmetricMatrix subtract(const Policy& policy, const TSymmetricMatrix& m) const
+    {
+        if (sz != m.sz) throw invalid_argument("Matrices must be of the same size for subtraction");
+        return TSymmetricMatrix(sz, elems.subtract(policy, m.elems));
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TSymmetricMatrix multiply(const Policy& policy, const T& val) const
+    {
+        return TSymmetricMatrix(sz, elems.multiply(policy, val));
+    }
+
+    // SYMV: y = this * x
+    TDynamicVector<T> operator*(const TDynamicVector<T>& v) const
+    {
+        return multiply(exec_par, v);
+    }
+    // строки берутся парами i и n - 1 - i (работа пары - n элементов), так что
+    // куски из равного числа пар равны по работе. Вклады a[i][j] * x[i] в y[j]
+    // кусок собирает в свой вектор-накопитель; кусков не больше числа потоков
+    // (при exec_par_det - SYMV_DET_ACCUMULATORS), и накопители складываются
+    // поэлементно в порядке кусков
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicVector<T> multiply(const Policy& policy, const TDynamicVector<T>& v) const
+    {
+        if (v.size() != sz) throw invalid_argument("Matrix columns and vector size must be equal for multiplication!");
+        const T* a = elems.data();
+        const T* x = v.data();
+        auto row = [&](size_t i, T* y) {
+            const T* ai = a + start(i) - i;   // ai[j] - элемент (i, j), j >= i
+            const T xi = x[i];
+            T s = ai[i] * xi;
+            for (size_t j = i + 1; j < sz; ++j)
+            {
+                s += ai[j] * x[j];
+                y[j] += ai[j] * xi;
+            }
+            y[i] += s;
+        };
+        size_t pairs = (sz + 1) / 2;
+        size_t limit = std::is_same<std::decay_t<Policy>, TDeterministicPolicy>::value ? SYMV_DET_ACCUMULATORS
+                                                                                      : TThreadPool::GetConcurrency();
+        TChunking chunks{ pairs, std::min(MakeChunking(policy, pairs, std::max<size_t>(1, PARALLEL_MIN_CHUNK / sz)).count, limit) };
+        std::vector<T> acc(chunks.count * sz);
+        ForEachChunk(policy, chunks.count, 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c)
+            {
+                T* y = acc.data() + c * sz;
+                for (size_t p = chunks.begin(c); p < chunks.end(c); ++p)
+                {
+                    row(p, y);
+                    if (sz - 1 - p != p)
+                        row(sz - 1 - p, y);
+                }
+            }
+        });
+
+        TDynamicVector<T> result(sz);
+        T* ys = result.data();
+        ForEachChunk(policy, sz, std::max<size_t>(1, PARALLEL_MIN_CHUNK / chunks.count), [&](size_t first, size_t last) {
+            for (size_t j = first; j < last; ++j)
+            {
+                T s = acc[j];
+                for (size_t c = 1; c < chunks.count; ++c)
+                    s += acc[c * sz + j];
+                ys[j] = s;
+            }
+        });
+        return result;
+    }
+
+    // SYMM: this * m; потоки делят столбцы m, и каждый проходит хранимый
+    // треугольник один раз, обновляя строки i и j своей полосы результата
+    TDynamicMatrix<T> operator*(const TDynamicMatrix<T>& m) const
+    {
+        return multiply(exec_par, m);
+    }
+    template<typename Policy, enable_if_exec_policy_t<Policy> = 0>
+    TDynamicMatrix<T> multiply(const Policy& policy, const TDynamicMatrix<T>& m) const
+    {
+        if (m.GetSize() != sz) throw invalid_argument("Matrix dimensions must match for multiplication!");
+        TDynamicMatrix<T> result(static_cast<int>(sz));
+        std::vector<T*> c(sz);
+        std::vector<const T*> b(sz);
+        for (size_t i = 0; i < sz; ++i)
+        {
+            c[i] = result[i].data();
+            b[i] = m[i].data();
+        }
+        const T* a = elems.data();
+        // полоса не уже 64 столбцов, чтобы внутренние циклы векторизовались
+        size_t grain = std::max<size_t>(64, PARALLEL_MIN_CHUNK / (sz * sz));
+        ForEachChunk(policy, sz, grain, [&](size_t c0, size_t c1) {
+            for (size_t i = 0; i < sz; ++i)
+            {
+                const T* ai = a + start(i) - i;
+                T* ci = c[i];
+                const T* bi = b[i];
+                for (size_t t = c0; t < c1; ++t)
+                    ci[t] += ai[i] * bi[t];
+                for (size_t j = i + 1; j < sz; ++j)
+                {
+                    const T aij = ai[j];
+                    const T* bj = b[j];
+                    T* cj = c[j];
+                    for (size_t t = c0; t < c1; ++t)
+                    {
+                        ci[t] += aij * bj[t];
+                        cj[t] += aij * bi[t];
+                    }
+                }
+            }
+        });
+        return result;
+    }
+
+private:
+    size_t sz;
+    TDynamicVector<T> elems;
+
+    TSymmetricMatrix(size_t n, TDynamicVector<T>&& e) : sz(n), elems(std::move(e)) {}
+
+    static size_t checkSize(size_t n)
+    {
+        if (n == 0)
+            throw out_of_range("Matrix size should be greater than zero");
+        if (n > MAX_MATRIX_SIZE)
+            throw out_of_range("Matrix size shouldn't be more than MAX_MATRIX_SIZE");
+        return n;
+    }
+
+    size_t start(size_t i) const noexcept { return i * sz - i * (i - 1) / 2; }
+};
+
+#endif
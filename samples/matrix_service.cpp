@@ -0,0 +1,48 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Резидентный вычислительный сервис (POSIX):
+//   matrix_service [имя сегмента] [число слотов] [максимальный размер матрицы]
+// Клиенты подключаются через TServiceClient с тем же именем сегмента.
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include "tservice.h"
+
+static TService* service = nullptr;
+
+static void onSignal(int)
+{
+    if (service != nullptr)
+        service->Stop();
+}
+
+int main(int argc, char* argv[])
+{
+    std::string name = argc > 1 ? argv[1] : "/tmatrix";
+    uint32_t slots = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 16;
+    uint32_t maxSize = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 1024;
+
+    try
+    {
+        TService s(name, slots, maxSize);
+        service = &s;
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+
+        // пул потоков запускается сразу, а не при первом задании
+        std::cout << "Matrix service " << name << ": " << slots << " slots up to "
+                  << maxSize << "x" << maxSize << ", " << TThreadPool::Instance().GetConcurrency()
+                  << " threads" << std::endl;
+        s.Run();
+        service = nullptr;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
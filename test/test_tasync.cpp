@@ -0,0 +1,151 @@
+#include "tasync.h"
+
+#include <gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+TDynamicMatrix<double> makeMatrix(int n, double base)
+{
+    TDynamicMatrix<double> m(n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            m[i][j] = base + i - j + (i == j ? n : 0);
+    return m;
+}
+
+TEST(TAsyncHandle, default_handle_is_not_valid)
+{
+    TAsyncHandle<int> h;
+
+    EXPECT_FALSE(h.IsValid());
+    EXPECT_THROW(h.Wait(), std::logic_error);
+}
+
+TEST(TAsyncHandle, can_get_result_of_async_operation)
+{
+    TAsyncHandle<int> h = Async([] { return 42; });
+
+    EXPECT_EQ(42, h.Get());
+    EXPECT_TRUE(h.IsReady());
+}
+
+TEST(TAsyncHandle, async_moves_callable_into_task)
+{
+    struct TCounted
+    {
+        std::shared_ptr<std::atomic<int>> copies;
+        TCounted(std::shared_ptr<std::atomic<int>> c) : copies(std::move(c)) {}
+        TCounted(const TCounted& other) : copies(other.copies) { ++*copies; }
+        TCounted(TCounted&&) = default;
+        int operator()() const { return 1; }
+    };
+    auto copies = std::make_shared<std::atomic<int>>(0);
+
+    TAsyncHandle<int> h = Async(TCounted(copies));
+
+    EXPECT_EQ(1, h.Get());
+    EXPECT_EQ(0, copies->load());
+}
+
+TEST(TAsyncHandle, can_run_move_only_callable)
+{
+    auto value = std::make_unique<int>(42);
+
+    TAsyncHandle<int> h = Async([value = std::move(value)] { return *value; });
+
+    EXPECT_EQ(42, h.Get());
+}
+
+TEST(TAsyncHandle, get_rethrows_exception_of_operation)
+{
+    TAsyncHandle<int> h = Async([]() -> int { throw std::runtime_error("failed"); });
+
+    EXPECT_THROW(h.Get(), std::runtime_error);
+}
+
+TEST(TAsyncHandle, callback_is_called_after_completion)
+{
+    std::atomic<int> calls{ 0 };
+    TAsyncHandle<int> h = Async([] { return 1; });
+
+    h.Then([&](const TAsyncHandle<int>& r) { calls += r.Get(); });
+    h.Wait();
+    h.Then([&](const TAsyncHandle<int>& r) { calls += r.Get(); });
+
+    // первый обратный вызов мог выполниться в другом потоке сразу после Wait
+    while (calls.load() < 2)
+        std::this_thread::yield();
+    EXPECT_EQ(2, calls.load());
+}
+
+TEST(TAsyncHandle, can_overlap_several_products)
+{
+    TDynamicMatrix<double> a = makeMatrix(30, 1), b = makeMatrix(30, 2);
+    TDynamicMatrix<double> expected = a * b;
+
+    std::vector<TAsyncHandle<TDynamicMatrix<double>>> handles;
+    for (int k = 0; k < 4; k++)
+        handles.push_back(MultiplyAsync(a, b));
+    WaitAll(handles);
+
+    for (auto& h : handles)
+        EXPECT_EQ(expected, h.Get());
+}
+
+TEST(TAsyncHandle, wait_any_returns_completed_operation)
+{
+    std::vector<TAsyncHandle<int>> handles;
+    handles.push_back(Async([] { return 1; }));
+    handles.push_back(Async([] { return 2; }));
+
+    size_t i = WaitAny(handles);
+
+    ASSERT_LT(i, handles.size());
+    EXPECT_TRUE(handles[i].IsReady());
+}
+
+TEST(TAsyncHandle, can_solve_asynchronously)
+{
+    TDynamicMatrix<double> a = makeMatrix(20, 0);
+    TDynamicVector<double> x(20);
+    for (int i = 0; i < 20; i++)
+        x[i] = i;
+    TDynamicVector<double> b = a * x;
+
+    TDynamicVector<double> res = SolveAsync(a, b).Get();
+
+    for (int i = 0; i < 20; i++)
+        EXPECT_NEAR(x[i], res[i], 1e-9);
+}
+
+TEST(TAsyncHandle, can_read_and_write_asynchronously)
+{
+    std::stringstream in("1 2\n3 4\n");
+    std::stringstream out;
+
+    TDynamicMatrix<int> m = ReadAsync<int>(in, 2).Get();
+    WriteAsync(out, m).Get();
+
+    EXPECT_EQ(4, m[1][1]);
+    EXPECT_EQ("1 2 \n3 4 \n", out.str());
+}
+
+TEST(TAsyncHandle, read_fails_on_bad_input)
+{
+    std::stringstream in("1 x");
+
+    EXPECT_THROW(ReadAsync<int>(in, 2).Get(), std::runtime_error);
+}
+
+TEST(TAsyncHandle, cancelled_async_product_rethrows_cancellation)
+{
+    TOperationControl control;
+    control.token.Cancel();
+    TAsyncHandle<TDynamicMatrix<double>> h = MultiplyAsync(makeMatrix(10, 1), makeMatrix(10, 2), control);
+
+    EXPECT_THROW(h.Get(), TOperationCancelled);
+}
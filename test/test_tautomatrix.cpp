@@ -0,0 +1,174 @@
+#include "tautomatrix.h"
+
+#include <gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+// ненулевые элементы (i, j), для которых pred(i, j) истинно
+template<typename F>
+TDynamicMatrix<double> makeMatrix(size_t n, F pred)
+{
+    TDynamicMatrix<double> m(static_cast<int>(n));
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            if (pred(i, j))
+                m[i][j] = static_cast<double>((i * 7 + j * 3) % 5 + 1) + (i == j ? 4.0 * n : 0.0);
+    return m;
+}
+
+TDynamicVector<double> makeVector(size_t n)
+{
+    TDynamicVector<double> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = static_cast<double>(i % 4) - 1.5;
+    return v;
+}
+
+void expectSameAsDense(const TAutoMatrix<double>& a, const TDynamicMatrix<double>& m)
+{
+    size_t n = m.GetSize();
+    TDynamicVector<double> v = makeVector(n);
+    TDynamicMatrix<double> b = makeMatrix(n, [](size_t i, size_t j) { return (i + j) % 3 != 0; });
+
+    EXPECT_EQ(m, a.ToDense());
+    EXPECT_EQ(m[n - 1][0], a(n - 1, 0));
+    EXPECT_EQ(m.multiply(exec_seq, v), a.multiply(exec_seq, v));
+    EXPECT_EQ(m.multiply(exec_seq, b), a * b);
+    TDynamicVector<double> x = a.Solve(v);
+    TDynamicVector<double> r = m.multiply(exec_seq, x);
+    for (size_t i = 0; i < n; i++)
+        EXPECT_NEAR(v[i], r[i], 1e-9);
+}
+}
+
+TEST(TAutoMatrix, analyzes_structure)
+{
+    TDynamicMatrix<double> m = makeMatrix(6, [](size_t i, size_t j) { return j + 1 >= i && j <= i + 2; });
+
+    TMatrixStructure s = AnalyzeStructure(exec_seq, m);
+
+    EXPECT_EQ(6u, s.size);
+    EXPECT_EQ(1u, s.lower);
+    EXPECT_EQ(2u, s.upper);
+    EXPECT_FALSE(s.symmetric);
+    EXPECT_EQ(6u + 5u + 5u + 4u, s.nonZeros);
+    EXPECT_EQ(s.lower, AnalyzeStructure(exec_seq, TCSRMatrix<double>(m)).lower);
+    EXPECT_EQ(s.nonZeros, AnalyzeStructure(exec_par_det, TCSRMatrix<double>(m)).nonZeros);
+}
+
+TEST(TAutoMatrix, chooses_diagonal_storage)
+{
+    TDynamicMatrix<double> m = makeMatrix(20, [](size_t i, size_t j) { return i == j; });
+    TAutoMatrix<double> a(m);
+
+    EXPECT_EQ(TMatrixStorage::Diagonal, a.GetStorage());
+    expectSameAsDense(a, m);
+}
+
+TEST(TAutoMatrix, chooses_band_storage)
+{
+    TDynamicMatrix<double> m = makeMatrix(50, [](size_t i, size_t j) { return j + 1 >= i && j <= i + 1; });
+    TAutoMatrix<double> a(m);
+
+    EXPECT_EQ(TMatrixStorage::Band, a.GetStorage());
+    EXPECT_EQ(1u, a.Get<TBandMatrix<double>>().GetUpper());
+    expectSameAsDense(a, m);
+}
+
+TEST(TAutoMatrix, chooses_upper_triangular_storage)
+{
+    TDynamicMatrix<double> m = makeMatrix(40, [](size_t i, size_t j) { return j >= i; });
+    TAutoMatrix<double> a(m);
+
+    EXPECT_EQ(TMatrixStorage::UpperTriangular, a.GetStorage());
+    expectSameAsDense(a, m);
+}
+
+TEST(TAutoMatrix, chooses_symmetric_storage)
+{
+    TDynamicMatrix<double> m = makeMatrix(40, [](size_t i, size_t j) { return i == j || (i + j) % 4 != 1; });
+    for (size_t i = 0; i < 40; i++)
+        for (size_t j = 0; j < i; j++)
+            m[i][j] = m[j][i];
+    TAutoMatrix<double> a(m);
+
+    EXPECT_TRUE(a.GetStructure().symmetric);
+    EXPECT_EQ(TMatrixStorage::Symmetric, a.GetStorage());
+    expectSameAsDense(a, m);
+}
+
+TEST(TAutoMatrix, chooses_sparse_storage)
+{
+    TDynamicMatrix<double> m = makeMatrix(200, [](size_t i, size_t j) { return i == j || (i * 31 + j * 17) % 97 == 0; });
+    TAutoMatrix<double> a(m);
+
+    EXPECT_LT(a.GetStructure().Density(), 0.05);
+    EXPECT_EQ(TMatrixStorage::Sparse, a.GetStorage());
+    expectSameAsDense(a, m);
+}
+
+TEST(TAutoMatrix, chooses_dense_storage)
+{
+    TDynamicMatrix<double> m = makeMatrix(40, [](size_t i, size_t j) { return i == j || (i * 3 + j) % 5 != 0; });
+    TAutoMatrix<double> a(m);
+
+    EXPECT_EQ(TMatrixStorage::Dense, a.GetStorage());
+    expectSameAsDense(a, m);
+}
+
+TEST(TAutoMatrix, never_chooses_sparse_storage_larger_than_dense)
+{
+    TMatrixStructure s;
+    s.size = 100;
+    s.lower = s.upper = 99;
+    s.symmetric = false;
+    s.nonZeros = 7000;   // CSR: 12 байт на элемент против 8 * 10000 у плотной
+
+    EXPECT_EQ(TMatrixStorage::Dense, ChooseStorage<double>(s));
+    s.nonZeros = 6000;
+    EXPECT_EQ(TMatrixStorage::Sparse, ChooseStorage<double>(s));
+}
+
+TEST(TAutoMatrix, keeps_large_matrices_out_of_dense_storage)
+{
+    size_t n = MAX_MATRIX_SIZE + 10;
+    TCOOBuilder<double> coo(n, n);
+    for (size_t i = 0; i < n; i++)
+    {
+        coo.Add(i, i, 4.0);
+        if (i > 0)
+            coo.Add(i, i - 1, -1.0);
+        if (i + 1 < n)
+            coo.Add(i, i + 1, -1.0);
+    }
+    TAutoMatrix<double> a(coo.ToCSR());
+
+    EXPECT_TRUE(a.GetStructure().symmetric);
+    EXPECT_EQ(TMatrixStorage::Band, a.GetStorage());
+    TDynamicVector<double> x(n);
+    x[0] = 1.0;
+    TDynamicVector<double> y = a * x;
+    EXPECT_EQ(4.0, y[0]);
+    EXPECT_EQ(-1.0, y[1]);
+    TDynamicVector<double> z = a.Solve(y);
+    EXPECT_NEAR(1.0, z[0], 1e-12);
+}
+
+TEST(TAutoMatrix, chooses_storage_again_on_load)
+{
+    TAutoMatrix<double> a(makeMatrix(3, [](size_t, size_t) { return true; }));
+    std::istringstream in("1 0 0\n0 2 0\n0 0 3\n");
+
+    in >> a;
+
+    EXPECT_EQ(TMatrixStorage::Diagonal, a.GetStorage());
+    EXPECT_EQ(2.0, a(1, 1));
+}
+
+TEST(TAutoMatrix, throws_when_sparse_matrix_is_not_square)
+{
+    EXPECT_THROW(TAutoMatrix<double>{ TCSRMatrix<double>(3, 4) }, std::invalid_argument);
+}
@@ -0,0 +1,165 @@
+#include "tbanded.h"
+
+#include <gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+
+TEST(TBandMatrix, can_create_band_matrix)
+{
+    TBandMatrix<int> m(5, 1, 2);
+
+    EXPECT_EQ(5u, m.GetSize());
+    EXPECT_EQ(1u, m.GetLower());
+    EXPECT_EQ(2u, m.GetUpper());
+}
+
+TEST(TBandMatrix, throws_when_bandwidth_is_too_large)
+{
+    EXPECT_THROW(TBandMatrix<int>(3, 3, 0), std::invalid_argument);
+    EXPECT_THROW(TBandMatrix<int>(0, 0, 0), std::invalid_argument);
+}
+
+TEST(TBandMatrix, can_set_and_get_elements)
+{
+    TBandMatrix<int> m(4, 1, 1);
+    m(1, 0) = 3;
+    m(1, 2) = 4;
+
+    EXPECT_EQ(3, m(1, 0));
+    EXPECT_EQ(4, m(1, 2));
+    EXPECT_EQ(0, static_cast<const TBandMatrix<int>&>(m)(0, 3));
+    EXPECT_THROW(m(0, 3), std::out_of_range);
+    EXPECT_THROW(m(4, 0), std::out_of_range);
+}
+
+TEST(TBandMatrix, dense_round_trip_keeps_matrix)
+{
+    TDynamicMatrix<int> a(6);
+    for (size_t i = 0; i < 6; i++)
+        for (size_t j = 0; j < 6; j++)
+            if (j + 2 >= i && j <= i + 1)
+                a[i][j] = static_cast<int>(i * 6 + j + 1);
+
+    TBandMatrix<int> m(a, 2, 1);
+
+    EXPECT_EQ(a, m.ToDense());
+    EXPECT_THROW(TBandMatrix<int>(a, 1, 1), std::invalid_argument);
+}
+
+TEST(TBandMatrix, product_with_vector_matches_dense)
+{
+    TDynamicMatrix<int> a(20);
+    TDynamicVector<int> v(20);
+    for (size_t i = 0; i < 20; i++)
+    {
+        v[i] = static_cast<int>(i) - 7;
+        for (size_t j = 0; j < 20; j++)
+            if (j + 3 >= i && j <= i + 2)
+                a[i][j] = static_cast<int>(i + 2 * j) % 7 - 3;
+    }
+    TBandMatrix<int> m(a, 3, 2);
+
+    EXPECT_EQ(a * v, m * v);
+    EXPECT_EQ(a * v, m.multiply(exec_seq, v));
+}
+
+TEST(TBandMatrix, solve_matches_dense_solve)
+{
+    // первый столбец мал, чтобы понадобились перестановки строк
+    TDynamicMatrix<double> a(30);
+    TDynamicVector<double> b(30);
+    for (size_t i = 0; i < 30; i++)
+    {
+        b[i] = static_cast<double>(i % 5) + 1;
+        for (size_t j = 0; j < 30; j++)
+            if (j + 2 >= i && j <= i + 1)
+                a[i][j] = static_cast<double>((i * 7 + j * 3) % 11) - 5 + (i == j ? 0.5 : 0);
+    }
+    a[0][0] = 1e-3;
+    TBandMatrix<double> m(a, 2, 1);
+
+    TDynamicVector<double> expected = a.Solve(b), x = m.Solve(b);
+
+    for (size_t i = 0; i < 30; i++)
+        EXPECT_NEAR(expected[i], x[i], 1e-9);
+}
+
+TEST(TBandMatrix, solve_throws_for_singular_matrix)
+{
+    TBandMatrix<double> m(3, 1, 1);
+    m(0, 0) = 1;
+    m(2, 2) = 1;
+    TDynamicVector<double> b(3);
+
+    EXPECT_THROW(m.Solve(b), std::runtime_error);
+}
+
+TEST(TBandLU, can_solve_several_right_hand_sides)
+{
+    const size_t n = 1000;
+    TBandMatrix<double> m(n, 2, 2);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = i > 2 ? i - 2 : 0; j <= std::min(n - 1, i + 2); j++)
+            m(i, j) = i == j ? 6.0 : -1.0;
+    TBandLU<double> lu(m);
+
+    for (size_t t = 1; t <= 3; t++)
+    {
+        TDynamicVector<double> x(n);
+        for (size_t i = 0; i < n; i++)
+            x[i] = std::sin(static_cast<double>(i * t));
+
+        TDynamicVector<double> r = lu.Solve(m * x);
+
+        for (size_t i = 0; i < n; i++)
+            ASSERT_NEAR(x[i], r[i], 1e-10);
+    }
+}
+
+TEST(SolveTridiagonal, matches_band_solve)
+{
+    const size_t n = 100;
+    TDynamicVector<double> lower(n), diag(n), upper(n), rhs(n);
+    TBandMatrix<double> m(n, 1, 1);
+    for (size_t i = 0; i < n; i++)
+    {
+        lower[i] = -1.0;
+        diag[i] = 4.0 + static_cast<double>(i % 3);
+        upper[i] = -2.0;
+        rhs[i] = static_cast<double>(i % 7);
+        m(i, i) = diag[i];
+        if (i > 0)
+            m(i, i - 1) = lower[i];
+        if (i + 1 < n)
+            m(i, i + 1) = upper[i];
+    }
+
+    TDynamicVector<double> expected = m.Solve(rhs), x = SolveTridiagonal(lower, diag, upper, rhs);
+
+    for (size_t i = 0; i < n; i++)
+        EXPECT_NEAR(expected[i], x[i], 1e-12);
+}
+
+TEST(SolveTridiagonal, can_solve_single_equation)
+{
+    TDynamicVector<double> a(1), b(1), c(1), d(1);
+    b[0] = 2;
+    d[0] = 3;
+
+    EXPECT_EQ(1.5, SolveTridiagonal(a, b, c, d)[0]);
+}
+
+TEST(SolveTridiagonal, throws_on_zero_pivot)
+{
+    TDynamicVector<double> a(2), b(2), c(2), d(2);
+
+    EXPECT_THROW(SolveTridiagonal(a, b, c, d), std::runtime_error);
+}
+
+TEST(SolveTridiagonal, throws_when_sizes_differ)
+{
+    TDynamicVector<double> a(2), b(3), c(3), d(3);
+
+    EXPECT_THROW(SolveTridiagonal(a, b, c, d), std::invalid_argument);
+}
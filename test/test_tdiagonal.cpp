@@ -0,0 +1,124 @@
+#include "tdiagonal.h"
+
+#include <gtest.h>
+
+#include <stdexcept>
+
+namespace
+{
+TDynamicMatrix<int> makeDense(size_t n)
+{
+    TDynamicMatrix<int> m(static_cast<int>(n));
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            m[i][j] = static_cast<int>((i * 3 + j * 5) % 11) - 5;
+    return m;
+}
+
+TDiagonalMatrix<int> makeDiagonal(size_t n)
+{
+    TDiagonalMatrix<int> d(n);
+    for (size_t i = 0; i < n; i++)
+        d[i] = static_cast<int>(i % 4) - 1;
+    return d;
+}
+}
+
+TEST(TDiagonalMatrix, off_diagonal_elements_are_zero)
+{
+    TDiagonalMatrix<int> d = makeDiagonal(4);
+
+    EXPECT_EQ(1, d(2, 2));
+    EXPECT_EQ(0, d(2, 1));
+    EXPECT_THROW(d(4, 0), std::out_of_range);
+}
+
+TEST(TDiagonalMatrix, products_match_dense)
+{
+    TDiagonalMatrix<int> d = makeDiagonal(37);
+    TDynamicMatrix<int> m = makeDense(37), dd = d.ToDense();
+    TDynamicVector<int> v(37);
+    for (size_t i = 0; i < 37; i++)
+        v[i] = static_cast<int>(i) - 10;
+
+    EXPECT_EQ(dd * v, d * v);
+    EXPECT_EQ(dd * m, d * m);
+    EXPECT_EQ(m * dd, m * d);
+    EXPECT_EQ(d * m, d.multiply(exec_seq, m));
+    EXPECT_EQ(m * d, d.multiplyLeft(exec_seq, m));
+}
+
+TEST(TDiagonalMatrix, diagonal_operations_stay_diagonal)
+{
+    TDiagonalMatrix<int> a = makeDiagonal(6), b = a * 3;
+
+    EXPECT_EQ(a.ToDense() * b.ToDense(), (a * b).ToDense());
+    EXPECT_EQ(a.ToDense() + b.ToDense(), (a + b).ToDense());
+    EXPECT_EQ(a.ToDense() - b.ToDense(), (a - b).ToDense());
+}
+
+TEST(TDiagonalMatrix, can_solve_system)
+{
+    TDiagonalMatrix<double> d(3);
+    d[0] = 2; d[1] = -4; d[2] = 0.5;
+    TDynamicVector<double> b(3);
+    b[0] = 2; b[1] = 8; b[2] = 1;
+
+    TDynamicVector<double> x = d.Solve(b);
+
+    EXPECT_EQ(1.0, x[0]);
+    EXPECT_EQ(-2.0, x[1]);
+    EXPECT_EQ(2.0, x[2]);
+    d[1] = 0;
+    EXPECT_THROW(d.Solve(b), std::runtime_error);
+}
+
+TEST(TDiagonalMatrix, throws_when_sizes_differ)
+{
+    TDiagonalMatrix<int> d(3);
+
+    EXPECT_THROW(d * TDynamicVector<int>(4), std::invalid_argument);
+    EXPECT_THROW(d * TDynamicMatrix<int>(4), std::invalid_argument);
+    EXPECT_THROW(TDynamicMatrix<int>(4) * d, std::invalid_argument);
+}
+
+TEST(TScaledIdentity, products_match_dense)
+{
+    TScaledIdentity<int> s(25, 3);
+    TDynamicMatrix<int> m = makeDense(25), sd = s.ToDense();
+    TDynamicVector<int> v(25);
+    for (size_t i = 0; i < 25; i++)
+        v[i] = static_cast<int>(i % 6);
+
+    EXPECT_EQ(3, sd[7][7]);
+    EXPECT_EQ(sd * v, s * v);
+    EXPECT_EQ(sd * m, s * m);
+    EXPECT_EQ(m * sd, m * s);
+}
+
+TEST(TScaledIdentity, combines_with_scaled_identity_and_diagonal)
+{
+    TScaledIdentity<int> a(5, 2), b(5, -3);
+    TDiagonalMatrix<int> d = makeDiagonal(5);
+
+    EXPECT_EQ(TScaledIdentity<int>(5, -6), a * b);
+    EXPECT_EQ(TScaledIdentity<int>(5, -1), a + b);
+    EXPECT_EQ(TScaledIdentity<int>(5, 8), a * 4);
+    EXPECT_EQ(d * 2, a * d);
+    EXPECT_EQ(d * 2, d * a);
+    EXPECT_THROW(a * TScaledIdentity<int>(6), std::invalid_argument);
+}
+
+TEST(TScaledIdentity, can_solve_system)
+{
+    TScaledIdentity<double> s(3, 4.0);
+    TDynamicVector<double> b(3);
+    b[0] = 4; b[1] = -8; b[2] = 2;
+
+    TDynamicVector<double> x = s.Solve(b);
+
+    EXPECT_EQ(1.0, x[0]);
+    EXPECT_EQ(-2.0, x[1]);
+    EXPECT_EQ(0.5, x[2]);
+    EXPECT_THROW(TScaledIdentity<double>(3, 0.0).Solve(b), std::runtime_error);
+}
@@ -166,3 +166,320 @@ TEST(TDynamicMatrix, cant_subtract_matrixes_with_not_equal_size)
     ASSERT_ANY_THROW(m1 - m2);
 }
 
+
+TEST(TDynamicMatrix, parallel_policy_operations_match_sequential_ones)
+{
+    TDynamicMatrix<int> m1(50), m2(50);
+    TDynamicVector<int> v(50);
+    for (int i = 0; i < 50; i++)
+    {
+        v[i] = i;
+        for (int j = 0; j < 50; j++)
+        {
+            m1[i][j] = i + j;
+            m2[i][j] = i * j;
+        }
+    }
+
+    EXPECT_EQ(m1 + m2, m1.add(exec_par, m2));
+    EXPECT_EQ(m1 - m2, m1.subtract(exec_par_unseq, m2));
+    EXPECT_EQ(m1 * 2, m1.multiply(exec_par, 2));
+    EXPECT_EQ(m1 * v, m1.multiply(exec_par, v));
+    EXPECT_EQ(m1.sum(exec_seq), m1.sum(exec_par));
+}
+
+TEST(TDynamicMatrix, deterministic_operations_do_not_depend_on_thread_count)
+{
+    const int n = 200;
+    TDynamicMatrix<double> m1(n), m2(n);
+    TDynamicVector<double> v(n);
+    for (int i = 0; i < n; i++)
+    {
+        v[i] = 1.0 / (i + 1);
+        for (int j = 0; j < n; j++)
+        {
+            m1[i][j] = (i - j) / 7.0 + 1e6 * (i == j);
+            m2[i][j] = 1.0 / (i + j + 1);
+        }
+    }
+
+    size_t old = TThreadPool::GetConcurrency();
+    TThreadPool::SetConcurrency(1);
+    double sum = m1.sum(exec_par_det);
+    double norm = m1.norm(exec_par_det);
+    TDynamicMatrix<double> product = m1.multiply(exec_par_det, m2);
+    TDynamicVector<double> mv = m1.multiply(exec_par_det, v);
+    for (size_t threads : { 2, 5, 16, 128 })
+    {
+        TThreadPool::SetConcurrency(threads);
+        EXPECT_EQ(sum, m1.sum(exec_par_det));
+        EXPECT_EQ(norm, m1.norm(exec_par_det));
+        EXPECT_EQ(product, m1.multiply(exec_par_det, m2));
+        EXPECT_EQ(mv, m1.multiply(exec_par_det, v));
+    }
+    TThreadPool::SetConcurrency(old);
+}
+
+TEST(TDynamicMatrix, elementwise_operations_do_not_depend_on_grain_size)
+{
+    const int n = 37;
+    TDynamicMatrix<int> m1(n), m2(n), sum(n), diff(n), scaled(n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        {
+            m1[i][j] = i * n + j;
+            m2[i][j] = i - j;
+            sum[i][j] = m1[i][j] + m2[i][j];
+            diff[i][j] = m1[i][j] - m2[i][j];
+            scaled[i][j] = m1[i][j] * 3;
+        }
+
+    for (size_t grain : { 1, 10, 37, 100, 1000000 })
+    {
+        EXPECT_EQ(sum, m1.add(exec_par, m2, grain));
+        EXPECT_EQ(diff, m1.subtract(exec_par, m2, grain));
+        EXPECT_EQ(scaled, m1.multiply(exec_par, 3, grain));
+    }
+    EXPECT_EQ(sum, m1 + m2);
+    EXPECT_EQ(diff, m1 - m2);
+    EXPECT_EQ(scaled, m1 * 3);
+}
+
+TEST(TDynamicMatrix, cant_add_matrices_with_not_equal_size_with_policy)
+{
+    TDynamicMatrix<int> m1(10), m2(20);
+
+    ASSERT_ANY_THROW(m1.add(exec_par, m2));
+}
+
+TEST(TDynamicMatrix, can_map_zip_and_apply_functions)
+{
+    TDynamicMatrix<int> m1(5), m2(5);
+    for (int i = 0; i < 5; i++)
+        for (int j = 0; j < 5; j++)
+        {
+            m1[i][j] = i;
+            m2[i][j] = j;
+        }
+
+    TDynamicMatrix<double> half = m1.map(exec_par, [](int a) { return a / 2.0; });
+    TDynamicMatrix<int> sum = m1.zipWith(m2, [](int a, int b) { return a + b; });
+    m1.apply([](int a) { return -a; });
+
+    EXPECT_DOUBLE_EQ(1.5, half[3][0]);
+    EXPECT_EQ(7, sum[3][4]);
+    EXPECT_EQ(-4, m1[4][2]);
+}
+
+TEST(TDynamicMatrix, can_transform_reduce_matrices)
+{
+    TDynamicMatrix<int> m1(5), m2(5);
+    for (int i = 0; i < 5; i++)
+        for (int j = 0; j < 5; j++)
+        {
+            m1[i][j] = 1;
+            m2[i][j] = i + j;
+        }
+
+    EXPECT_EQ(100 + 3, m1.transformReduce(m2, 3, std::plus<int>(), std::multiplies<int>()));
+    EXPECT_EQ(100 + 3, m1.transformReduce(exec_par, m2, 3, std::plus<int>(), std::multiplies<int>()));
+}
+
+TEST(TDynamicMatrix, can_solve_linear_system)
+{
+    TDynamicMatrix<double> m(3);
+    m[0][0] = 0; m[0][1] = 2; m[0][2] = 1;
+    m[1][0] = 1; m[1][1] = 1; m[1][2] = 1;
+    m[2][0] = 2; m[2][1] = 1; m[2][2] = 3;
+    TDynamicVector<double> x(3);
+    x[0] = 1; x[1] = -2; x[2] = 3;
+    TDynamicVector<double> b = m * x;
+
+    TDynamicVector<double> res = m.Solve(b);
+    TDynamicVector<double> resPar = m.Solve(exec_par, b);
+
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_NEAR(x[i], res[i], 1e-12);
+        EXPECT_NEAR(x[i], resPar[i], 1e-12);
+    }
+}
+
+TEST(TDynamicMatrix, throws_when_solve_singular_system)
+{
+    TDynamicMatrix<double> m(2);
+    m[0][0] = 1; m[0][1] = 2;
+    m[1][0] = 2; m[1][1] = 4;
+
+    EXPECT_THROW(m.Solve(TDynamicVector<double>(2)), std::runtime_error);
+}
+
+TEST(TDynamicMatrix, can_create_matrix_with_numa_placement)
+{
+    TDynamicMatrix<int> local(300, TMemoryPlacement::Local);
+    TDynamicMatrix<int> interleaved(300, TMemoryPlacement::Interleave);
+    TDynamicMatrix<int> plain(300, TMemoryPlacement::Default);
+
+    EXPECT_EQ(300u, local.GetSize());
+    EXPECT_EQ(plain, local);
+    EXPECT_EQ(plain, interleaved);
+    EXPECT_EQ(0, interleaved.sum(exec_par));
+}
+
+TEST(TDynamicMatrix, copy_on_write_copy_shares_rows)
+{
+    TDynamicMatrix<int> m(5);
+    m.SetCopyOnWrite(true);
+    TDynamicMatrix<int> c(m);
+
+    EXPECT_TRUE(m.IsShared());
+    EXPECT_TRUE(c.IsCopyOnWrite());
+    EXPECT_EQ(m, c);
+}
+
+TEST(TDynamicMatrix, copy_on_write_copies_only_written_row)
+{
+    TDynamicMatrix<int> m(5);
+    for (int i = 0; i < 5; i++)
+        for (int j = 0; j < 5; j++)
+            m[i][j] = i * 5 + j;
+    m.SetCopyOnWrite(true);
+    TDynamicMatrix<int> c(m);
+
+    c[1][2] = -1;
+    c(3, 3) = -2;
+
+    const TDynamicMatrix<int>& cm = m;
+    const TDynamicMatrix<int>& cc = c;
+    EXPECT_EQ(7, m[1][2]);
+    EXPECT_EQ(18, m[3][3]);
+    EXPECT_EQ(-1, c[1][2]);
+    EXPECT_EQ(-2, c[3][3]);
+    EXPECT_FALSE(m.IsShared());
+    EXPECT_EQ(cm[0].data(), cc[0].data());
+    EXPECT_NE(cm[1].data(), cc[1].data());
+}
+
+TEST(TDynamicMatrix, operations_do_not_change_copy_on_write_copies)
+{
+    TDynamicMatrix<double> m(3);
+    TDynamicVector<double> b(3);
+    for (int i = 0; i < 3; i++)
+    {
+        b[i] = 1;
+        for (int j = 0; j < 3; j++)
+            m[i][j] = i == j ? 4 : 1;
+    }
+    m.SetCopyOnWrite(true);
+    TDynamicMatrix<double> c(m), d(m);
+
+    c.Solve(exec_par, b);
+    d.apply(exec_par, [](double x) { return 2 * x; });
+
+    EXPECT_EQ(c, m);
+    EXPECT_EQ(4, m[0][0]);
+    EXPECT_EQ(8, d[0][0]);
+}
+
+TEST(TDynamicMatrix, multiply_rows_does_not_change_copy_on_write_copies)
+{
+    TDynamicMatrix<int> a(3), b(3), c(3);
+    for (int i = 0; i < 3; i++)
+    {
+        a[i][i] = 2;
+        for (int j = 0; j < 3; j++)
+            b[i][j] = i + j;
+    }
+    c.SetCopyOnWrite(true);
+    TDynamicMatrix<int> d(c);
+
+    TDynamicMatrix<int>::MultiplyRows(a, b, c, 0, 3, 0, 3);
+
+    EXPECT_EQ(a * b, c);
+    EXPECT_EQ(TDynamicMatrix<int>(3), d);
+}
+
+TEST(TDynamicMatrix, product_with_control_reports_progress)
+{
+    const int n = 20;
+    TDynamicMatrix<int> m1(n), m2(n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        {
+            m1[i][j] = i + j;
+            m2[i][j] = i - j;
+        }
+    TOperationControl control;
+    std::vector<size_t> reports;
+    control.progress = [&](size_t done, size_t total) {
+        EXPECT_EQ(static_cast<size_t>(n), total);
+        reports.push_back(done);
+    };
+
+    EXPECT_EQ(m1 * m2, m1.multiply(exec_par, m2, control));
+    ASSERT_FALSE(reports.empty());
+    EXPECT_EQ(static_cast<size_t>(n), reports.back());
+    for (size_t i = 1; i < reports.size(); i++)
+        EXPECT_LT(reports[i - 1], reports[i]);
+}
+
+TEST(TDynamicMatrix, cancelled_product_throws)
+{
+    TDynamicMatrix<int> m(10);
+    TOperationControl control;
+    TCancellationToken token = control.token;
+    token.Cancel();
+
+    EXPECT_THROW(m.multiply(exec_par, m, control), TOperationCancelled);
+}
+
+TEST(TDynamicMatrix, product_can_be_cancelled_from_progress_callback)
+{
+    const int n = 50;
+    TDynamicMatrix<double> m(n);
+    TOperationControl control;
+    size_t last = 0;
+    control.progress = [&](size_t done, size_t) {
+        last = done;
+        if (done >= 5)
+            control.token.Cancel();
+    };
+
+    EXPECT_THROW(m.multiply(exec_seq, m, control), TOperationCancelled);
+    EXPECT_EQ(5u, last);
+}
+
+TEST(TDynamicMatrix, product_throws_after_deadline)
+{
+    TDynamicMatrix<int> m(10);
+    TOperationControl control;
+    control.SetTimeout(std::chrono::milliseconds(-1));
+
+    EXPECT_THROW(m.multiply(exec_par, m, control), TDeadlineExceeded);
+}
+
+TEST(TDynamicMatrix, solve_with_control_reports_each_step)
+{
+    const int n = 8;
+    TDynamicMatrix<double> m(n);
+    TDynamicVector<double> b(n);
+    for (int i = 0; i < n; i++)
+    {
+        b[i] = 1;
+        for (int j = 0; j < n; j++)
+            m[i][j] = i == j ? n : 1;
+    }
+    TOperationControl control;
+    size_t steps = 0;
+    control.progress = [&](size_t done, size_t total) {
+        steps++;
+        EXPECT_EQ(steps, done);
+        EXPECT_EQ(static_cast<size_t>(n), total);
+    };
+
+    EXPECT_EQ(m.Solve(b), m.Solve(exec_par, b, control));
+    EXPECT_EQ(static_cast<size_t>(n), steps);
+
+    control.token.Cancel();
+    EXPECT_THROW(m.Solve(exec_par, b, control), TOperationCancelled);
+}
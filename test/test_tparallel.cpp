@@ -0,0 +1,209 @@
+#include "tparallel.h"
+
+#include <gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(TThreadPool, concurrency_is_positive)
+{
+    EXPECT_GT(TThreadPool::GetConcurrency(), 0u);
+}
+
+TEST(TThreadPool, cant_set_zero_concurrency)
+{
+    EXPECT_THROW(TThreadPool::SetConcurrency(0), std::invalid_argument);
+}
+
+TEST(TThreadPool, can_change_concurrency)
+{
+    size_t old = TThreadPool::GetConcurrency();
+
+    TThreadPool::SetConcurrency(3);
+    EXPECT_EQ(3u, TThreadPool::GetConcurrency());
+
+    std::atomic<int> sum{ 0 };
+    ParallelFor(1000, 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+            sum += static_cast<int>(i);
+    });
+    EXPECT_EQ(499500, sum.load());
+
+    TThreadPool::SetConcurrency(old);
+}
+
+TEST(TThreadPool, restart_runs_pending_tasks)
+{
+    size_t old = TThreadPool::GetConcurrency();
+    TThreadPool::SetConcurrency(1);
+    bool ran = false;
+
+    // без рабочих потоков задачу некому взять до перезапуска
+    TThreadPool::Instance().Submit([&] { ran = true; });
+    TThreadPool::SetConcurrency(3);
+
+    EXPECT_TRUE(ran);
+    std::atomic<int> count{ 0 };
+    TTaskGroup group;
+    for (int i = 0; i < 100; i++)
+        group.Run([&] { count++; });
+    group.Wait();
+    EXPECT_EQ(100, count.load());
+
+    TThreadPool::SetConcurrency(old);
+}
+
+TEST(TThreadPool, cant_restart_from_pool_task)
+{
+    size_t old = TThreadPool::GetConcurrency();
+    TThreadPool::SetConcurrency(2);
+    std::atomic<int> result{ 0 };
+
+    TThreadPool::Instance().SubmitTo(0, [&] {
+        try
+        {
+            TThreadPool::SetConcurrency(3);
+            result = 1;
+        }
+        catch (const std::logic_error&)
+        {
+            result = 2;
+        }
+    });
+    while (result.load() == 0)
+        std::this_thread::yield();
+
+    EXPECT_EQ(2, result.load());
+    EXPECT_EQ(2u, TThreadPool::GetConcurrency());
+    TThreadPool::SetConcurrency(old);
+}
+
+TEST(TTaskGroup, runs_all_tasks)
+{
+    std::atomic<int> count{ 0 };
+    TTaskGroup group;
+
+    for (int i = 0; i < 100; i++)
+        group.Run([&] { count++; });
+    group.Wait();
+
+    EXPECT_EQ(100, count.load());
+}
+
+TEST(TTaskGroup, rethrows_exception_from_task)
+{
+    TTaskGroup group;
+
+    group.Run([] { throw std::runtime_error("task failed"); });
+
+    EXPECT_THROW(group.Wait(), std::runtime_error);
+}
+
+TEST(ParallelFor, covers_range_exactly_once)
+{
+    const size_t n = 100003;
+    std::vector<int> hits(n, 0);
+
+    ParallelFor(n, 100, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+            hits[i]++;
+    });
+
+    for (size_t i = 0; i < n; i++)
+        ASSERT_EQ(1, hits[i]);
+}
+
+TEST(ParallelFor, supports_nested_parallelism)
+{
+    const size_t n = 64;
+    std::vector<long long> sums(n, 0);
+
+    ParallelFor(n, 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+        {
+            std::atomic<long long> s{ 0 };
+            ParallelFor(1000, 10, [&](size_t b, size_t e) {
+                long long local = 0;
+                for (size_t j = b; j < e; j++)
+                    local += static_cast<long long>(j);
+                s += local;
+            });
+            sums[i] = s;
+        }
+    });
+
+    for (size_t i = 0; i < n; i++)
+        EXPECT_EQ(499500, sums[i]);
+}
+
+TEST(ParallelFor, rethrows_exception_from_body)
+{
+    EXPECT_THROW(ParallelFor(1000, 1, [](size_t first, size_t last) {
+        if (first <= 500 && 500 < last)
+            throw std::out_of_range("chunk failed");
+    }), std::out_of_range);
+}
+
+TEST(ParallelForStatic, assigns_chunks_to_the_same_threads_every_time)
+{
+    const size_t n = 1000;
+    std::vector<std::thread::id> first(n), second(n);
+
+    ParallelForStatic(n, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++)
+            first[i] = std::this_thread::get_id();
+    });
+    ParallelForStatic(n, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++)
+            second[i] = std::this_thread::get_id();
+    });
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(std::this_thread::get_id(), first[0]);
+}
+
+TEST(TThreadPool, can_change_placement_and_pinning)
+{
+    TThreadPool::SetPlacement(TMemoryPlacement::Local);
+    TThreadPool::SetPinThreads(true);
+
+    std::atomic<int> sum{ 0 };
+    ParallelFor(1000, 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+            sum += static_cast<int>(i);
+    });
+
+    EXPECT_EQ(TMemoryPlacement::Local, TThreadPool::GetPlacement());
+    EXPECT_TRUE(TThreadPool::GetPinThreads());
+    EXPECT_EQ(499500, sum.load());
+
+    TThreadPool::SetPinThreads(false);
+    TThreadPool::SetPlacement(TMemoryPlacement::Default);
+}
+
+TEST(ReduceChunks, deterministic_policy_uses_fixed_chunks)
+{
+    size_t old = TThreadPool::GetConcurrency();
+    for (size_t threads : { 1, 4, 32 })
+    {
+        TThreadPool::SetConcurrency(threads);
+        std::atomic<int> calls{ 0 };
+        std::atomic<int> longest{ 0 };
+        int sum = ReduceChunks(exec_par_det, 1000, 64, 0, [&](size_t first, size_t last) {
+            calls++;
+            if (static_cast<int>(last - first) > longest)
+                longest = static_cast<int>(last - first);
+            int s = 0;
+            for (size_t i = first; i < last; i++)
+                s += static_cast<int>(i);
+            return s;
+        });
+
+        EXPECT_EQ(499500, sum);
+        EXPECT_EQ(16, calls.load());
+        EXPECT_EQ(63, longest.load());
+    }
+    TThreadPool::SetConcurrency(old);
+}
@@ -0,0 +1,192 @@
+#if defined(__cpp_impl_coroutine)
+
+#include "tpipeline.h"
+
+#include <gtest.h>
+
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+TStage produce(TChannel<int>& out, int count, std::atomic<int>* produced = nullptr)
+{
+    TChannelCloser<int> closer(out);
+    for (int i = 0; i < count; i++)
+    {
+        if (!co_await out.Push(i))
+            break;
+        if (produced)
+            ++*produced;
+    }
+}
+
+TStage consume(TChannel<int>& in, std::vector<int>& items)
+{
+    TChannelCloser<int> closer(in);
+    while (std::optional<int> v = co_await in.Pop())
+        items.push_back(*v);
+}
+
+TStage failAfter(TChannel<int>& in, int count)
+{
+    TChannelCloser<int> closer(in);
+    for (int i = 0; i < count; i++)
+        co_await in.Pop();
+    throw std::runtime_error("stage failed");
+}
+}
+
+TEST(TPipeline, can_run_empty_pipeline)
+{
+    TPipeline p;
+
+    ASSERT_NO_THROW(p.Run());
+}
+
+TEST(TPipeline, items_pass_through_channel_in_order)
+{
+    TChannel<int> ch(2);
+    std::vector<int> items;
+    TPipeline p;
+    p.Add(produce(ch, 100)).Add(consume(ch, items));
+
+    p.Run();
+
+    ASSERT_EQ(100u, items.size());
+    for (int i = 0; i < 100; i++)
+        EXPECT_EQ(i, items[i]);
+}
+
+TEST(TPipeline, can_chain_transform_stages)
+{
+    TChannel<int> a(1), b(1), c(1);
+    std::vector<int> items;
+    TPipeline p;
+    p.Add(produce(a, 10))
+     .Add(Transform(a, b, [](int v) { return v * 2; }))
+     .Add(Transform(b, c, [](int v) { return v + 1; }))
+     .Add(consume(c, items));
+
+    p.Run();
+
+    ASSERT_EQ(10, items.size());
+    for (int i = 0; i < 10; i++)
+        EXPECT_EQ(2 * i + 1, items[i]);
+}
+
+TEST(TPipeline, unbuffered_channel_hands_items_over_directly)
+{
+    TChannel<int> ch(0);
+    std::vector<int> items;
+    TPipeline p;
+    p.Add(produce(ch, 20)).Add(consume(ch, items));
+
+    p.Run();
+
+    EXPECT_EQ(20, items.size());
+}
+
+TEST(TPipeline, producer_is_not_ahead_of_consumer_more_than_capacity)
+{
+    TChannel<int> in(1), out(2);
+    std::atomic<int> produced{ 0 };
+    std::atomic<int> maxLead{ 0 };
+    int consumed = 0;
+    std::vector<int> items;
+    TPipeline p;
+    p.Add(produce(in, 50, &produced))
+     .Add(Transform(in, out, [&](int v) {
+         int lead = produced - consumed;
+         if (lead > maxLead)
+             maxLead = lead;
+         consumed++;
+         return v;
+     }))
+     .Add(consume(out, items));
+
+    p.Run();
+
+    EXPECT_EQ(50, items.size());
+    // элемент в канале, элемент в ожидающем Push и обрабатываемый элемент
+    EXPECT_LE(maxLead, 3);
+}
+
+TEST(TPipeline, throws_when_stage_throws_and_does_not_hang)
+{
+    TChannel<int> ch(1);
+    TPipeline p;
+    p.Add(produce(ch, 1000)).Add(failAfter(ch, 3));
+
+    try
+    {
+        p.Run();
+        FAIL();
+    }
+    catch (const std::runtime_error& e)
+    {
+        EXPECT_STREQ("stage failed", e.what());
+    }
+}
+
+TEST(TPipeline, push_to_closed_channel_fails)
+{
+    TChannel<int> ch(1);
+    std::vector<int> items;
+    ch.Close();
+    TPipeline p;
+    p.Add(produce(ch, 10)).Add(consume(ch, items));
+
+    p.Run();
+
+    EXPECT_TRUE(items.empty());
+}
+
+TEST(TPipeline, can_read_multiply_and_write_matrices)
+{
+    const int n = 3, count = 5;
+    TDynamicMatrix<double> factor(n);
+    std::stringstream input;
+    std::vector<TDynamicMatrix<double>> expected;
+    for (int i = 0; i < n; i++)
+        factor[i][i] = 2;
+    for (int k = 0; k < count; k++)
+    {
+        TDynamicMatrix<double> m(n);
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+                m[i][j] = k + i * n + j;
+        input << m << "\n";
+        expected.push_back(m * factor);
+    }
+
+    std::stringstream output;
+    TChannel<TDynamicMatrix<double>> parsed(2), computed(2);
+    TPipeline p;
+    p.Add(ReadMatrices(input, n, parsed))
+     .Add(Transform(parsed, computed, [&](TDynamicMatrix<double> m) { return m * factor; }))
+     .Add(WriteMatrices(computed, output));
+    p.Run();
+
+    for (int k = 0; k < count; k++)
+    {
+        TDynamicMatrix<double> m(n);
+        output >> m;
+        EXPECT_EQ(expected[k], m);
+    }
+}
+
+TEST(TPipeline, throws_on_truncated_matrix_input)
+{
+    std::stringstream input("1 2 3 4 5");
+    std::stringstream output;
+    TChannel<TDynamicMatrix<double>> parsed(1);
+    TPipeline p;
+    p.Add(ReadMatrices(input, 2, parsed)).Add(WriteMatrices(parsed, output));
+
+    EXPECT_THROW(p.Run(), std::runtime_error);
+}
+
+#endif
@@ -0,0 +1,357 @@
+#if defined(__unix__) || defined(__APPLE__)
+
+#include "tservice.h"
+
+#include <gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+
+namespace
+{
+std::string serviceName()
+{
+    static int counter = 0;
+    return "/tmatrix_test_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+}
+
+// сервис в отдельном потоке на время теста
+class TRunningService
+{
+public:
+    TRunningService(const std::string& name, uint32_t slots, uint32_t maxSize)
+        : service(name, slots, maxSize), thread([this] { service.Run(); }) {}
+    ~TRunningService()
+    {
+        service.Stop();
+        thread.join();
+    }
+
+    TService service;
+    std::thread thread;
+};
+
+TDynamicMatrix<double> makeServiceMatrix(int n, double base)
+{
+    TDynamicMatrix<double> m(n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            m[i][j] = base + i * n - j;
+    return m;
+}
+
+// прямой доступ к сегменту - как у клиента, пишущего в него что угодно
+class TRawSegment
+{
+public:
+    TRawSegment(const std::string& name, uint32_t slots, uint32_t maxSize)
+        : size(TServiceLayout::totalSize(slots, maxSize))
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        base = static_cast<char*>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+        close(fd);
+        stride = TServiceLayout::slotStride(maxSize);
+        slotsOffset = TServiceLayout::slotsOffset(slots);
+    }
+    ~TRawSegment()
+    {
+        munmap(base, size);
+    }
+
+    TServiceLayout::THeader* Header() const { return reinterpret_cast<TServiceLayout::THeader*>(base); }
+    uint32_t* Ring() const { return reinterpret_cast<uint32_t*>(base + TServiceLayout::ringOffset()); }
+    TServiceLayout::TSlot* Slot(uint32_t i) const
+    {
+        return reinterpret_cast<TServiceLayout::TSlot*>(base + slotsOffset + i * stride);
+    }
+    void Push(uint32_t index) const
+    {
+        TServiceLayout::THeader* h = Header();
+        pthread_mutex_lock(&h->mutex);
+        Ring()[h->tail % h->slotCount] = index;
+        h->tail++;
+        pthread_cond_signal(&h->submitted);
+        pthread_mutex_unlock(&h->mutex);
+    }
+
+private:
+    size_t size;
+    char* base;
+    size_t stride;
+    size_t slotsOffset;
+};
+}
+
+TEST(TService, cant_connect_without_service)
+{
+    EXPECT_THROW(TServiceClient client(serviceName()), std::runtime_error);
+}
+
+TEST(TService, cant_create_service_without_slots)
+{
+    EXPECT_THROW(TService(serviceName(), 0, 10), std::invalid_argument);
+}
+
+TEST(TService, cant_start_second_service_with_same_name)
+{
+    std::string name = serviceName();
+    TRunningService running(name, 2, 8);
+
+    EXPECT_THROW(TService(name, 2, 8), std::runtime_error);
+
+    TServiceClient client(name);
+    TDynamicMatrix<double> a = makeServiceMatrix(4, 1), b = makeServiceMatrix(4, 3);
+    EXPECT_EQ(a.multiply(exec_seq, b), client.Multiply(a, b));
+}
+
+TEST(TService, reclaims_memory_left_by_dead_service)
+{
+    std::string name = serviceName();
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0)
+    {
+        // завершение без деструктора оставляет сегмент
+        TService* leaked = new TService(name, 2, 8);
+        (void)leaked;
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+
+    TRunningService running(name, 2, 8);
+    TServiceClient client(name);
+    TDynamicMatrix<double> a = makeServiceMatrix(4, 2), b = makeServiceMatrix(4, 5);
+    EXPECT_EQ(a.multiply(exec_seq, b), client.Multiply(a, b));
+}
+
+TEST(TService, does_not_remove_foreign_or_starting_segment)
+{
+    std::string name = serviceName();
+    // сегмент без заголовка - как у сервиса, ещё не задавшего размер
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    EXPECT_THROW(TService(name, 2, 8), std::runtime_error);
+
+    fd = shm_open(name.c_str(), O_RDWR, 0);
+    EXPECT_GE(fd, 0);
+    close(fd);
+    shm_unlink(name.c_str());
+}
+
+TEST(TService, client_detects_crashed_service)
+{
+    std::string name = serviceName();
+    int ready[2];
+    ASSERT_EQ(0, pipe(ready));
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0)
+    {
+        // сервис принимает задания, но не выполняет их
+        TService* service = new TService(name, 1, 4);
+        (void)service;
+        char c = 1;
+        (void)!write(ready[1], &c, 1);
+        pause();
+        _exit(0);
+    }
+    char c;
+    ASSERT_EQ(1, read(ready[0], &c, 1));
+    close(ready[0]);
+    close(ready[1]);
+    {
+        TServiceClient client(name);
+        TServiceJob job = client.Acquire(TServiceOp::MultiplyVector, 1);
+        client.Submit(job);
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+
+        EXPECT_THROW(client.Wait(job), std::runtime_error);
+        EXPECT_THROW(client.Acquire(TServiceOp::MultiplyVector, 1), std::runtime_error);
+    }
+    shm_unlink(name.c_str());
+}
+
+TEST(TService, reclaims_slot_of_crashed_client)
+{
+    std::string name = serviceName();
+    TRunningService running(name, 1, 4);
+
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0)
+    {
+        // завершение без деструктора задания оставляет слот занятым
+        TServiceClient client(name);
+        TServiceJob* job = new TServiceJob(client.Acquire(TServiceOp::Multiply, 2));
+        (void)job;
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+
+    TServiceClient client(name);
+    TDynamicMatrix<double> a = makeServiceMatrix(3, 1), b = makeServiceMatrix(3, 2);
+    EXPECT_EQ(a.multiply(exec_seq, b), client.Multiply(a, b));
+}
+
+TEST(TService, can_multiply_matrices)
+{
+    std::string name = serviceName();
+    TRunningService running(name, 4, 16);
+    TServiceClient client(name);
+    TDynamicMatrix<double> a = makeServiceMatrix(10, 1), b = makeServiceMatrix(10, -2);
+
+    EXPECT_EQ(a * b, client.Multiply(a, b));
+}
+
+TEST(TService, can_multiply_matrix_by_vector)
+{
+    std::string name = serviceName();
+    TRunningService running(name, 2, 16);
+    TServiceClient client(name);
+    TDynamicMatrix<double> a = makeServiceMatrix(16, 3);
+    TDynamicVector<double> x(16);
+    for (int i = 0; i < 16; i++)
+        x[i] = i - 4;
+
+    EXPECT_EQ(a * x, client.Multiply(a, x));
+}
+
+TEST(TService, operands_are_written_in_place)
+{
+    std::string name = serviceName();
+    TRunningService running(name, 1, 4);
+    TServiceClient client(name);
+
+    TServiceJob job = client.Acquire(TServiceOp::Multiply, 2);
+    double* a = job.Operand(0);
+    double* b = job.Operand(1);
+    a[0] = 1; a[1] = 2; a[2] = 3; a[3] = 4;
+    b[0] = 1; b[1] = 0; b[2] = 0; b[3] = 1;
+    EXPECT_THROW(job.Result(), std::logic_error);
+    client.Submit(job);
+    client.Wait(job);
+
+    const double* c = job.Result();
+    EXPECT_EQ(1, c[0]);
+    EXPECT_EQ(2, c[1]);
+    EXPECT_EQ(3, c[2]);
+    EXPECT_EQ(4, c[3]);
+}
+
+TEST(TService, ignores_invalid_and_unsubmitted_ring_entries)
+{
+    std::string name = serviceName();
+    TRunningService running(name, 2, 4);
+    TRawSegment raw(name, 2, 4);
+
+    raw.Push(1000);
+    raw.Push(0);
+    while (raw.Header()->head != 2)
+        std::this_thread::yield();
+    TServiceClient client(name);
+    TDynamicMatrix<double> a = makeServiceMatrix(4, 1), b = makeServiceMatrix(4, 3);
+
+    EXPECT_EQ(a * b, client.Multiply(a, b));
+    EXPECT_EQ(TServiceLayout::Free, raw.Slot(1)->state.load());
+}
+
+TEST(TService, runs_submitted_jobs_after_ring_overflow)
+{
+    std::string name = serviceName();
+    TRunningService running(name, 2, 4);
+    TRawSegment raw(name, 2, 4);
+    TServiceClient client(name);
+
+    TServiceJob job = client.Acquire(TServiceOp::MultiplyVector, 1);
+    job.Operand(0)[0] = 3;
+    job.Operand(1)[0] = 4;
+    // задание отправлено, но в кольце вместо него больше записей, чем слотов
+    TServiceLayout::THeader* h = raw.Header();
+    pthread_mutex_lock(&h->mutex);
+    raw.Slot(0)->state.store(TServiceLayout::Submitted);
+    h->tail += 3;
+    pthread_cond_signal(&h->submitted);
+    pthread_mutex_unlock(&h->mutex);
+    client.Wait(job);
+
+    EXPECT_EQ(12, job.Result()[0]);
+}
+
+TEST(TService, fails_job_with_size_changed_after_acquire)
+{
+    std::string name = serviceName();
+    TRunningService running(name, 1, 4);
+    TRawSegment raw(name, 1, 4);
+    TServiceClient client(name);
+
+    TServiceJob job = client.Acquire(TServiceOp::Multiply, 2);
+    raw.Slot(0)->n = 1000000;
+    client.Submit(job);
+
+    EXPECT_THROW(client.Wait(job), std::runtime_error);
+}
+
+TEST(TService, cant_acquire_job_larger_than_service_limit)
+{
+    std::string name = serviceName();
+    TRunningService running(name, 1, 4);
+    TServiceClient client(name);
+
+    EXPECT_THROW(client.Acquire(TServiceOp::Multiply, 5), std::invalid_argument);
+}
+
+TEST(TService, batches_jobs_from_many_clients)
+{
+    std::string name = serviceName();
+    TRunningService running(name, 3, 12);
+    std::vector<std::thread> clients;
+    std::vector<int> ok(8, 0);
+    for (int t = 0; t < 8; t++)
+        clients.emplace_back([&, t] {
+            TServiceClient client(name);
+            TDynamicMatrix<double> a = makeServiceMatrix(4 + t, t), b = makeServiceMatrix(4 + t, 1);
+            ok[t] = client.Multiply(a, b) == a * b;
+        });
+    for (auto& c : clients)
+        c.join();
+
+    for (int t = 0; t < 8; t++)
+        EXPECT_EQ(1, ok[t]);
+}
+
+TEST(TService, serves_other_processes)
+{
+    std::string name = serviceName();
+    TRunningService running(name, 2, 8);
+
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0)
+    {
+        int code = 1;
+        try
+        {
+            TServiceClient client(name);
+            TDynamicMatrix<double> a = makeServiceMatrix(8, 2), b = makeServiceMatrix(8, 5);
+            code = client.Multiply(a, b) == a.multiply(exec_seq, b) ? 0 : 2;
+        }
+        catch (...) {}
+        _exit(code);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+#endif
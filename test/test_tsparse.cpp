@@ -0,0 +1,519 @@
+#include "tsparse.h"
+
+#include <gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+// трёхдиагональная матрица -1, 2, -1
+TCSRMatrix<double> makeLaplacian(size_t n)
+{
+    std::vector<size_t> rowPtr(n + 1, 0);
+    std::vector<TCSRMatrix<double>::Index> colInd;
+    std::vector<double> values;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i > 0)
+        {
+            colInd.push_back(static_cast<TCSRMatrix<double>::Index>(i - 1));
+            values.push_back(-1);
+        }
+        colInd.push_back(static_cast<TCSRMatrix<double>::Index>(i));
+        values.push_back(2);
+        if (i + 1 < n)
+        {
+            colInd.push_back(static_cast<TCSRMatrix<double>::Index>(i + 1));
+            values.push_back(-1);
+        }
+        rowPtr[i + 1] = values.size();
+    }
+    return TCSRMatrix<double>(n, n, rowPtr, colInd, values);
+}
+}
+
+TEST(TCSRMatrix, can_create_zero_matrix)
+{
+    TCSRMatrix<int> m(3, 5);
+
+    EXPECT_EQ(3u, m.GetRows());
+    EXPECT_EQ(5u, m.GetCols());
+    EXPECT_EQ(0u, m.GetNonZeros());
+    EXPECT_EQ(0, m(2, 4));
+}
+
+TEST(TCSRMatrix, cant_create_matrix_with_zero_size)
+{
+    EXPECT_THROW(TCSRMatrix<int>(0, 3), std::invalid_argument);
+}
+
+TEST(TCSRMatrix, throws_on_invalid_arrays)
+{
+    EXPECT_THROW(TCSRMatrix<int>(2, 2, { 0, 1 }, { 0 }, { 1 }), std::invalid_argument);
+    EXPECT_THROW(TCSRMatrix<int>(2, 2, { 0, 1, 2 }, { 0, 2 }, { 1, 1 }), std::invalid_argument);
+    EXPECT_THROW(TCSRMatrix<int>(1, 3, { 0, 2 }, { 1, 0 }, { 1, 1 }), std::invalid_argument);
+    EXPECT_THROW(TCSRMatrix<int>(2, 2, { 0, 2, 1 }, { 0 }, { 1 }), std::invalid_argument);
+}
+
+TEST(TCSRMatrix, can_get_elements)
+{
+    TCSRMatrix<int> m(2, 3, { 0, 2, 3 }, { 0, 2, 1 }, { 1, 2, 3 });
+
+    EXPECT_EQ(1, m(0, 0));
+    EXPECT_EQ(0, m(0, 1));
+    EXPECT_EQ(2, m(0, 2));
+    EXPECT_EQ(3, m(1, 1));
+    EXPECT_THROW(m(2, 0), std::out_of_range);
+}
+
+TEST(TCSRMatrix, dense_round_trip_keeps_matrix)
+{
+    TDynamicMatrix<int> a(50);
+    for (size_t i = 0; i < 50; i++)
+        for (size_t j = 0; j < 50; j++)
+            if ((i * 7 + j * 3) % 5 == 0)
+                a[i][j] = static_cast<int>(i + j + 1);
+
+    TCSRMatrix<int> s(a);
+
+    EXPECT_EQ(500u, s.GetNonZeros());
+    EXPECT_EQ(a, s.ToDense());
+    EXPECT_EQ(s, TCSRMatrix<int>(exec_seq, a));
+}
+
+TEST(TCSRMatrix, cant_convert_rectangular_matrix_to_dense)
+{
+    TCSRMatrix<int> m(2, 3);
+
+    EXPECT_THROW(m.ToDense(), std::invalid_argument);
+}
+
+TEST(TCSRMatrix, product_with_vector_matches_dense)
+{
+    TDynamicMatrix<int> a(40);
+    TDynamicVector<int> v(40);
+    for (size_t i = 0; i < 40; i++)
+    {
+        v[i] = static_cast<int>(i) - 20;
+        for (size_t j = 0; j < 40; j++)
+            if ((i + j) % 3 == 0)
+                a[i][j] = static_cast<int>(i * j % 11);
+    }
+    TCSRMatrix<int> s(a);
+
+    EXPECT_EQ(a * v, s * v);
+    EXPECT_EQ(a * v, s.multiply(exec_seq, v));
+    EXPECT_EQ(a * v, s.multiply(exec_par_det, v));
+}
+
+TEST(TCSRMatrix, can_multiply_rectangular_matrix_by_vector)
+{
+    TCSRMatrix<int> m(2, 3, { 0, 2, 3 }, { 0, 2, 1 }, { 1, 2, 3 });
+    TDynamicVector<int> v(3);
+    v[0] = 1; v[1] = 2; v[2] = 3;
+
+    TDynamicVector<int> r = m * v;
+
+    ASSERT_EQ(2u, r.size());
+    EXPECT_EQ(7, r[0]);
+    EXPECT_EQ(6, r[1]);
+}
+
+TEST(TCSRMatrix, throws_when_multiply_by_vector_with_wrong_size)
+{
+    TCSRMatrix<int> m(2, 3);
+    TDynamicVector<int> v(2);
+
+    EXPECT_THROW(m * v, std::invalid_argument);
+}
+
+TEST(TCSRMatrix, can_multiply_matrix_with_million_rows)
+{
+    const size_t n = 1000000;
+    TCSRMatrix<double> m = makeLaplacian(n);
+    TDynamicVector<double> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = static_cast<double>(i);
+
+    TDynamicVector<double> r = m * v;
+
+    // вторая разность линейной функции - ноль во внутренних точках
+    EXPECT_EQ(-1.0, r[0]);
+    EXPECT_EQ(0.0, r[n / 2]);
+    EXPECT_EQ(static_cast<double>(n), r[n - 1]);
+    EXPECT_EQ(r, m.multiply(exec_seq, v));
+}
+
+TEST(TCSRMatrix, transpose_matches_dense)
+{
+    TCSRMatrix<int> m(2, 3, { 0, 2, 3 }, { 0, 2, 1 }, { 1, 2, 3 });
+
+    TCSRMatrix<int> t = m.Transpose();
+
+    ASSERT_EQ(3u, t.GetRows());
+    ASSERT_EQ(2u, t.GetCols());
+    for (size_t i = 0; i < 2; i++)
+        for (size_t j = 0; j < 3; j++)
+            EXPECT_EQ(m(i, j), t(j, i));
+    EXPECT_EQ(m, t.Transpose(exec_seq));
+}
+
+TEST(TCSCMatrix, can_get_elements)
+{
+    TCSCMatrix<int> m(2, 3, { 0, 1, 2, 3 }, { 0, 1, 0 }, { 1, 3, 2 });
+
+    EXPECT_EQ(1, m(0, 0));
+    EXPECT_EQ(3, m(1, 1));
+    EXPECT_EQ(2, m(0, 2));
+    EXPECT_EQ(0, m(1, 2));
+    EXPECT_THROW(m(0, 3), std::out_of_range);
+}
+
+TEST(TCSCMatrix, throws_on_invalid_arrays)
+{
+    EXPECT_THROW(TCSCMatrix<int>(2, 3, { 0, 1, 2 }, { 0, 1 }, { 1, 1 }), std::invalid_argument);
+    EXPECT_THROW(TCSCMatrix<int>(2, 3, { 0, 1, 2, 3 }, { 0, 2, 0 }, { 1, 1, 1 }), std::invalid_argument);
+}
+
+TEST(TCSCMatrix, csr_round_trip_keeps_matrix)
+{
+    TCSRMatrix<int> m(2, 3, { 0, 2, 3 }, { 0, 2, 1 }, { 1, 2, 3 });
+
+    TCSCMatrix<int> c(m);
+
+    EXPECT_EQ(3u, c.GetNonZeros());
+    EXPECT_EQ(std::vector<size_t>({ 0, 1, 2, 3 }), c.ColPtr());
+    EXPECT_EQ(std::vector<TCSCMatrix<int>::Index>({ 0, 1, 0 }), c.RowIndices());
+    EXPECT_EQ(m, c.ToCSR());
+}
+
+TEST(TCSCMatrix, dense_round_trip_keeps_matrix)
+{
+    TDynamicMatrix<int> a(30);
+    for (size_t i = 0; i < 30; i++)
+        for (size_t j = 0; j < 30; j++)
+            if ((i + 2 * j) % 7 == 1)
+                a[i][j] = static_cast<int>(i * 30 + j);
+
+    TCSCMatrix<int> c(a);
+
+    EXPECT_EQ(a(4, 5), c(4, 5));
+    EXPECT_EQ(a, c.ToDense());
+}
+
+TEST(TCOOBuilder, sums_duplicates)
+{
+    TCOOBuilder<int> b(2, 3);
+    b.Add(1, 2, 5);
+    b.Add(0, 1, 1);
+    b.Add(1, 2, 7);
+    b.Add(0, 0, 2);
+    b.Add(0, 1, 3);
+
+    TCSRMatrix<int> m = b.ToCSR();
+
+    EXPECT_EQ(5u, b.GetCount());
+    EXPECT_EQ(3u, m.GetNonZeros());
+    EXPECT_EQ(2, m(0, 0));
+    EXPECT_EQ(4, m(0, 1));
+    EXPECT_EQ(12, m(1, 2));
+}
+
+TEST(TCOOBuilder, throws_when_index_is_out_of_range)
+{
+    TCOOBuilder<int> b(2, 3);
+
+    EXPECT_THROW(b.Add(2, 0, 1), std::out_of_range);
+    EXPECT_THROW(b.Add(0, 3, 1), std::out_of_range);
+}
+
+TEST(TCOOBuilder, csr_and_csc_describe_same_matrix)
+{
+    TCOOBuilder<int> b(50, 40);
+    for (size_t k = 0; k < 1000; k++)
+        b.Add(k * 17 % 50, k * 13 % 40, static_cast<int>(k % 9) - 4);
+
+    TCSRMatrix<int> csr = b.ToCSR();
+    TCSCMatrix<int> csc = b.ToCSC();
+
+    EXPECT_EQ(csr, csc.ToCSR());
+    EXPECT_EQ(csc, TCSCMatrix<int>(csr));
+    EXPECT_EQ(csr, b.ToCSR(exec_seq));
+}
+
+TEST(TCOOBuilder, assembles_large_matrix)
+{
+    const size_t n = 200000;
+    TCOOBuilder<double> b(n, n);
+    b.Reserve(4 * n);
+    // каждая диагональная позиция добавляется дважды, в обратном порядке строк
+    for (size_t i = n; i-- > 0;)
+    {
+        b.Add(i, i, 1.0);
+        if (i + 1 < n)
+            b.Add(i, i + 1, -1.0);
+        if (i > 0)
+            b.Add(i, i - 1, -1.0);
+        b.Add(i, i, 1.0);
+    }
+
+    TCSRMatrix<double> m = b.ToCSR();
+
+    EXPECT_EQ(3 * n - 2, m.GetNonZeros());
+    EXPECT_EQ(m, makeLaplacian(n));
+    EXPECT_EQ(m, b.ToCSR(exec_par_det));
+}
+
+TEST(TSparseProduct, product_matches_dense)
+{
+    TDynamicMatrix<int> a(40), b(40);
+    for (size_t i = 0; i < 40; i++)
+        for (size_t j = 0; j < 40; j++)
+        {
+            if ((i * 5 + j) % 7 == 0)
+                a[i][j] = static_cast<int>(i + j) % 5 - 2;
+            if ((i + j * 3) % 6 == 1)
+                b[i][j] = static_cast<int>(i * j) % 7 - 3;
+        }
+    TCSRMatrix<int> sa(a), sb(b);
+
+    TCSRMatrix<int> c = sa * sb;
+
+    EXPECT_EQ(a * b, c.ToDense());
+    EXPECT_EQ(c, sa.multiply(exec_seq, sb));
+    EXPECT_EQ(c, sa.multiply(exec_par_det, sb));
+}
+
+TEST(TSparseProduct, keeps_structural_zeros)
+{
+    // (1 1) * (1 -1)^T = 0, но позиция остаётся в структуре
+    TCSRMatrix<int> a(1, 2, { 0, 2 }, { 0, 1 }, { 1, 1 });
+    TCSRMatrix<int> b(2, 1, { 0, 1, 2 }, { 0, 0 }, { 1, -1 });
+
+    TCSRMatrix<int> c = a * b;
+
+    EXPECT_EQ(1u, c.GetNonZeros());
+    EXPECT_EQ(0, c(0, 0));
+}
+
+TEST(TSparseProduct, can_multiply_rectangular_matrices)
+{
+    TCSRMatrix<int> a(2, 3, { 0, 2, 3 }, { 0, 2, 1 }, { 1, 2, 3 });
+
+    TCSRMatrix<int> c = a * a.Transpose();
+
+    ASSERT_EQ(2u, c.GetRows());
+    ASSERT_EQ(2u, c.GetCols());
+    EXPECT_EQ(5, c(0, 0));
+    EXPECT_EQ(0, c(0, 1));
+    EXPECT_EQ(9, c(1, 1));
+}
+
+TEST(TSparseProduct, throws_when_dimensions_do_not_match)
+{
+    TCSRMatrix<int> a(2, 3), b(2, 3);
+
+    EXPECT_THROW(a * b, std::invalid_argument);
+}
+
+TEST(TSparseProduct, can_reuse_structure_with_new_values)
+{
+    TCSRMatrix<double> a = makeLaplacian(1000);
+    TSparseProduct<double> p(exec_par, a, a);
+    TCSRMatrix<double> c = p.Compute(a, a);
+    EXPECT_EQ(5u * 1000 - 6, p.GetNonZeros());
+    EXPECT_EQ(6.0, c(500, 500));
+
+    std::vector<double> values = a.Values();
+    for (double& v : values)
+        v *= 2;
+    TCSRMatrix<double> a2(1000, 1000, a.RowPtr(), a.ColIndices(), values);
+    p.Compute(exec_par, a2, a2, c);
+
+    EXPECT_EQ(24.0, c(500, 500));
+    EXPECT_EQ(a2 * a2, c);
+}
+
+TEST(TSparseProduct, throws_when_operands_do_not_match_structure)
+{
+    TCSRMatrix<double> a = makeLaplacian(100);
+    TSparseProduct<double> p(exec_par, a, a);
+    TCSRMatrix<double> b = makeLaplacian(101);
+
+    EXPECT_THROW(p.Compute(b, b), std::invalid_argument);
+}
+
+TEST(TSparseProduct, throws_when_operand_pattern_differs)
+{
+    // те же размеры и число ненулевых, другие столбцы
+    TCSRMatrix<double> a(3, 3, { 0, 1, 2, 3 }, { 0, 1, 2 }, { 1, 2, 3 });
+    TCSRMatrix<double> b(3, 3, { 0, 1, 2, 3 }, { 2, 0, 1 }, { 1, 2, 3 });
+    TSparseProduct<double> p(exec_par, a, a);
+    TCSRMatrix<double> c = p.Compute(a, a);
+
+    EXPECT_THROW(p.Compute(b, b), std::invalid_argument);
+    EXPECT_THROW(p.Compute(exec_seq, a, b, c), std::invalid_argument);
+    EXPECT_EQ(a * a, p.Compute(exec_seq, a, a));
+}
+
+TEST(ThreadMarks, releases_array_of_large_matrix)
+{
+    std::vector<uint32_t>& big = ThreadMarks<uint32_t>(4 * SPARSE_MARKS_KEEP);
+    EXPECT_EQ(4 * SPARSE_MARKS_KEEP, big.size());
+
+    std::vector<uint32_t>& small = ThreadMarks<uint32_t>(100);
+
+    EXPECT_LT(small.capacity(), 4 * SPARSE_MARKS_KEEP);
+    EXPECT_EQ(static_cast<uint32_t>(-1), small[SPARSE_MARKS_KEEP - 1]);
+}
+
+TEST(TCSRMatrix, product_with_dense_matrix_matches_dense)
+{
+    TDynamicMatrix<int> a(30), b(30);
+    for (size_t i = 0; i < 30; i++)
+        for (size_t j = 0; j < 30; j++)
+        {
+            if ((i * 3 + j) % 4 == 0)
+                a[i][j] = static_cast<int>(i + j) % 5 - 2;
+            b[i][j] = static_cast<int>(i * j) % 7 - 3;
+        }
+    TCSRMatrix<int> s(a);
+
+    EXPECT_EQ(a * b, s * b);
+    EXPECT_EQ(a * b, s.multiply(exec_seq, b));
+    EXPECT_EQ(b * a, b * s);
+    EXPECT_EQ(b * a, s.multiplyLeft(exec_par_det, b));
+}
+
+TEST(TCSRMatrix, throws_when_multiply_by_dense_matrix_with_wrong_size)
+{
+    TCSRMatrix<int> s(3, 3);
+    TDynamicMatrix<int> m(4);
+
+    EXPECT_THROW(s * m, std::invalid_argument);
+    EXPECT_THROW(m * s, std::invalid_argument);
+}
+
+TEST(TCSRMatrix, block_product_matches_spmv_for_each_vector)
+{
+    const size_t n = 5000, k = 3;
+    TCSRMatrix<double> s = makeLaplacian(n);
+    std::vector<double> x(n * k), y(n * k);
+    for (size_t i = 0; i < n; i++)
+        for (size_t t = 0; t < k; t++)
+            x[i * k + t] = static_cast<double>((i * (t + 1)) % 17);
+
+    s.multiply(exec_par, x.data(), k, y.data());
+
+    for (size_t t = 0; t < k; t++)
+    {
+        TDynamicVector<double> v(n);
+        for (size_t i = 0; i < n; i++)
+            v[i] = x[i * k + t];
+        TDynamicVector<double> r = s * v;
+        for (size_t i = 0; i < n; i++)
+            ASSERT_EQ(r[i], y[i * k + t]);
+    }
+}
+
+TEST(TCSRMatrix, left_block_product_matches_transposed_product)
+{
+    TCSRMatrix<int> s(2, 3, { 0, 2, 3 }, { 0, 2, 1 }, { 1, 2, 3 });
+    std::vector<int> x = { 1, 2, 3, 4 }; // 2 x 2
+    std::vector<int> y(6);
+
+    s.multiplyLeft(exec_par, x.data(), 2, y.data());
+
+    EXPECT_EQ(std::vector<int>({ 1, 6, 2, 3, 12, 6 }), y);
+}
+
+namespace
+{
+// матрица из плотных блоков b x b на блочной трёхдиагонали
+TCSRMatrix<double> makeBlockMatrix(size_t blocks, size_t b)
+{
+    TCOOBuilder<double> builder(blocks * b, blocks * b);
+    for (size_t bi = 0; bi < blocks; bi++)
+        for (size_t bj = bi == 0 ? 0 : bi - 1; bj <= bi + 1 && bj < blocks; bj++)
+            for (size_t r = 0; r < b; r++)
+                for (size_t c = 0; c < b; c++)
+                    builder.Add(bi * b + r, bj * b + c, static_cast<double>((bi * 7 + bj * 3 + r * 5 + c) % 11) + 1);
+    return builder.ToCSR();
+}
+}
+
+TEST(TBSRMatrix, csr_round_trip_keeps_matrix)
+{
+    TCSRMatrix<double> m = makeBlockMatrix(20, 3);
+
+    TBSRMatrix<double> b(exec_par, m, 3);
+
+    EXPECT_EQ(3u, b.GetBlockSize());
+    EXPECT_EQ(58u, b.GetBlockCount());
+    EXPECT_EQ(m(4, 7), b(4, 7));
+    EXPECT_EQ(0.0, b(0, 8));
+    EXPECT_EQ(m, b.ToCSR());
+}
+
+TEST(TBSRMatrix, pads_partial_blocks_with_zeros)
+{
+    TCSRMatrix<int> m(4, 4, { 0, 1, 1, 2, 3 }, { 0, 3, 1 }, { 1, 2, 3 });
+
+    TBSRMatrix<int> b(exec_seq, m, 2);
+
+    EXPECT_EQ(3u, b.GetBlockCount());
+    EXPECT_EQ(12u, b.Values().size());
+    EXPECT_EQ(m, b.ToCSR());
+}
+
+TEST(TBSRMatrix, throws_when_size_is_not_multiple_of_block_size)
+{
+    TCSRMatrix<int> m(4, 6);
+
+    EXPECT_THROW(TBSRMatrix<int>(exec_par, m, 3), std::invalid_argument);
+    EXPECT_THROW(TBSRMatrix<int>(exec_par, m, 0), std::invalid_argument);
+}
+
+TEST(TBSRMatrix, detects_block_size)
+{
+    EXPECT_EQ(3u, TBSRMatrix<double>::DetectBlockSize(makeBlockMatrix(40, 3)));
+    EXPECT_EQ(4u, TBSRMatrix<double>::DetectBlockSize(makeBlockMatrix(30, 4)));
+    EXPECT_EQ(1u, TBSRMatrix<double>::DetectBlockSize(makeLaplacian(120)));
+    EXPECT_EQ(4u, TBSRMatrix<double>(makeBlockMatrix(30, 4)).GetBlockSize());
+}
+
+TEST(TBSRMatrix, product_with_vector_matches_csr)
+{
+    for (size_t bs : { 2, 3, 4, 5 })
+    {
+        TCSRMatrix<double> m = makeBlockMatrix(50, bs);
+        TBSRMatrix<double> b(exec_par, m, bs);
+        TDynamicVector<double> v(m.GetCols());
+        for (size_t i = 0; i < v.size(); i++)
+            v[i] = static_cast<double>(i % 13) - 6;
+
+        TDynamicVector<double> expected = m * v, actual = b * v;
+
+        for (size_t i = 0; i < v.size(); i++)
+            ASSERT_NEAR(expected[i], actual[i], 1e-9);
+        EXPECT_EQ(actual, b.multiply(exec_seq, v));
+    }
+}
+
+TEST(TBSRMatrix, block_product_matches_csr)
+{
+    TCSRMatrix<double> m = makeBlockMatrix(40, 3);
+    TBSRMatrix<double> b(exec_par, m, 3);
+    const size_t k = 5, n = m.GetRows();
+    std::vector<double> x(n * k), expected(n * k), actual(n * k);
+    for (size_t i = 0; i < x.size(); i++)
+        x[i] = static_cast<double>(i % 7);
+
+    m.multiply(exec_par, x.data(), k, expected.data());
+    b.multiply(exec_par, x.data(), k, actual.data());
+
+    EXPECT_EQ(expected, actual);
+    TDynamicMatrix<double> d = m.ToDense();
+    EXPECT_EQ(m * d, b * d);
+}
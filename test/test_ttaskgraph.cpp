@@ -0,0 +1,163 @@
+#include "ttaskgraph.h"
+
+#include <gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+TEST(TTaskGraph, runs_tasks_after_their_dependencies)
+{
+    TTaskGraph g;
+    std::mutex m;
+    std::vector<int> order;
+    auto record = [&](int v) { return [&, v] { std::lock_guard<std::mutex> lock(m); order.push_back(v); }; };
+
+    TTaskGraph::TaskId a = g.AddTask(record(1));
+    TTaskGraph::TaskId b = g.AddTask(record(2), { a });
+    TTaskGraph::TaskId c = g.AddTask(record(3), { a });
+    g.AddTask(record(4), { b, c });
+    g.Run();
+
+    ASSERT_EQ(4u, order.size());
+    EXPECT_EQ(1, order.front());
+    EXPECT_EQ(4, order.back());
+}
+
+TEST(TTaskGraph, cant_depend_on_unknown_task)
+{
+    TTaskGraph g;
+
+    EXPECT_THROW(g.AddTask([] {}, { 5 }), std::invalid_argument);
+}
+
+TEST(TTaskGraph, can_run_graph_twice)
+{
+    TTaskGraph g;
+    std::atomic<int> count{ 0 };
+    TTaskGraph::TaskId a = g.AddTask([&] { count++; });
+    g.AddTask([&] { count++; }, { a });
+
+    g.Run();
+    g.Run();
+
+    EXPECT_EQ(4, count.load());
+}
+
+TEST(TTaskGraph, stops_and_rethrows_on_exception)
+{
+    TTaskGraph g;
+    bool after = false;
+    TTaskGraph::TaskId a = g.AddTask([] { throw std::runtime_error("tile failed"); });
+    g.AddTask([&] { after = true; }, { a });
+
+    EXPECT_THROW(g.Run(), std::runtime_error);
+    EXPECT_FALSE(after);
+}
+
+TEST(TTaskGraph, long_chain_does_not_overflow_stack)
+{
+    TTaskGraph g;
+    int count = 0;
+    TTaskGraph::TaskId prev = g.AddTask([&] { count++; });
+    for (int i = 0; i < 100000; i++)
+        prev = g.AddTask([&] { count++; }, { prev });
+
+    g.Run();
+
+    EXPECT_EQ(100001, count);
+}
+
+TEST(TTiledMatrix, chained_product_and_sum_match_operators)
+{
+    const int n = 37;
+    TDynamicMatrix<double> a(n), b(n), e(n), ab(n), abe(n), sum(n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        {
+            a[i][j] = i - j;
+            b[i][j] = (i * j) % 7;
+            e[i][j] = i + 2 * j;
+        }
+
+    TTaskGraph g;
+    TTiledMatrix<double> ta(a, 8), tb(b, 8), te(e, 8);
+    TTiledMatrix<double> tab = AddProduct(g, ta, tb, ab);
+    TTiledMatrix<double> tabe = AddProduct(g, tab, te, abe);
+    AddSum(g, tabe, tab, sum);
+    g.Run();
+
+    TDynamicMatrix<double> expected = a * b;
+    EXPECT_EQ(expected, ab);
+    EXPECT_EQ(expected * e, abe);
+    EXPECT_EQ(abe + ab, sum);
+}
+
+TEST(TTiledMatrix, cant_write_product_into_operand)
+{
+    TDynamicMatrix<double> a(4), b(4);
+    TTaskGraph g;
+    TTiledMatrix<double> ta(a, 2), tb(b, 2);
+
+    EXPECT_THROW(AddProduct(g, ta, tb, a), std::invalid_argument);
+}
+
+TEST(TTaskGraph, write_depends_on_earlier_reads_and_writes)
+{
+    TTaskGraph g;
+    int buffer = 0;
+    TTaskGraph::TaskId w = g.AddTask([] {});
+    g.Record(&buffer, 0, 4, true, w);
+    TTaskGraph::TaskId r = g.AddTask([] {}, g.Hazards(&buffer, 2, 3, false));
+    g.Record(&buffer, 2, 3, false, r);
+
+    EXPECT_EQ(std::vector<TTaskGraph::TaskId>({ w }), g.Hazards(&buffer, 0, 1, true));
+    EXPECT_EQ(std::vector<TTaskGraph::TaskId>({ w, r }), g.Hazards(&buffer, 0, 4, true));
+    EXPECT_EQ(std::vector<TTaskGraph::TaskId>({ w }), g.Hazards(&buffer, 0, 4, false));
+}
+
+TEST(TTiledMatrix, can_reuse_matrix_read_by_earlier_task)
+{
+    const int n = 40;
+    TDynamicMatrix<double> a(n), b(n), d(n), c(n), e(n), a2(n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        {
+            a[i][j] = i - j;
+            b[i][j] = (i * j) % 5;
+            d[i][j] = i + j;
+            a2[i][j] = (i + 3 * j) % 11;
+        }
+
+    TTaskGraph g;
+    TTiledMatrix<double> ta(a, 8), tb(b, 8), td(d, 8), ta2(a2, 8);
+    TTiledMatrix<double> tc = AddProduct(g, ta, tb, c);
+    AddSum(g, tc, td, e);
+    // c перезаписывается после того, как его прочитала сумма
+    AddProduct(g, ta2, tb, c);
+    g.Run();
+
+    EXPECT_EQ(a * b + d, e);
+    EXPECT_EQ(a2 * b, c);
+}
+
+TEST(TTiledMatrix, can_add_in_place)
+{
+    const int n = 20;
+    TDynamicMatrix<double> a(n), b(n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        {
+            a[i][j] = i * j;
+            b[i][j] = i - j;
+        }
+    TDynamicMatrix<double> expected = a + b;
+
+    TTaskGraph g;
+    TTiledMatrix<double> ta(a, 6), tb(b, 6);
+    AddSum(g, ta, tb, a);
+    g.Run();
+
+    EXPECT_EQ(expected, a);
+}
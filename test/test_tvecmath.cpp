@@ -0,0 +1,193 @@
+#include "tvecmath.h"
+
+#include <gtest.h>
+
+#include <cmath>
+
+template<typename T, typename F, typename G>
+double maxRelativeError(const TDynamicVector<T>& x, F approx, G exact)
+{
+    TDynamicVector<T> r = approx(x);
+    double err = 0;
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        double e = exact(static_cast<double>(x[i]));
+        double d = std::fabs(static_cast<double>(r[i]) - e) / std::max(std::fabs(e), 1e-300);
+        err = std::max(err, d);
+    }
+    return err;
+}
+
+TDynamicVector<double> range(double lo, double hi, size_t n)
+{
+    TDynamicVector<double> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = lo + (hi - lo) * i / (n - 1);
+    return v;
+}
+
+TEST(TVecMath, balanced_exp_is_accurate_for_double)
+{
+    TDynamicVector<double> x = range(-700, 700, 10001);
+
+    double err = maxRelativeError(x, [](const TDynamicVector<double>& v) { return Exp(v); },
+        [](double a) { return std::exp(a); });
+
+    EXPECT_LT(err, 1e-14);
+}
+
+TEST(TVecMath, fast_exp_is_less_accurate_but_close)
+{
+    TDynamicVector<double> x = range(-50, 50, 1001);
+
+    double err = maxRelativeError(x, [](const TDynamicVector<double>& v) { return Exp(v, TMathAccuracy::Fast); },
+        [](double a) { return std::exp(a); });
+
+    EXPECT_LT(err, 1e-7);
+}
+
+TEST(TVecMath, exp_handles_special_values)
+{
+    TDynamicVector<double> x(4);
+    x[0] = 1000;
+    x[1] = -1000;
+    x[2] = 0;
+    x[3] = NAN;
+
+    TDynamicVector<double> r = Exp(x);
+
+    EXPECT_TRUE(std::isinf(r[0]));
+    EXPECT_EQ(0, r[1]);
+    EXPECT_EQ(1, r[2]);
+    EXPECT_TRUE(std::isnan(r[3]));
+}
+
+TEST(TVecMath, exp_is_finite_up_to_overflow_threshold)
+{
+    TDynamicVector<double> x = range(709.0, 709.78, 101);
+
+    double err = maxRelativeError(x, [](const TDynamicVector<double>& v) { return Exp(v); },
+        [](double a) { return std::exp(a); });
+
+    EXPECT_LT(err, 1e-14);
+    TDynamicVector<double> big(1);
+    big[0] = 709.79;
+    EXPECT_TRUE(std::isinf(Exp(big)[0]));
+}
+
+TEST(TVecMath, exp_is_finite_up_to_overflow_threshold_for_float)
+{
+    TDynamicVector<float> x(3);
+    x[0] = 88.5f;
+    x[1] = 88.72f;
+    x[2] = 88.73f;
+
+    TDynamicVector<float> r = Exp(x);
+
+    EXPECT_NEAR(std::exp(88.5f), r[0], 1e-6 * std::exp(88.5f));
+    EXPECT_NEAR(std::exp(88.72f), r[1], 1e-6 * std::exp(88.72f));
+    EXPECT_TRUE(std::isinf(r[2]));
+}
+
+TEST(TVecMath, exp_returns_subnormal_results)
+{
+    TDynamicVector<double> x = range(-745.0, -708.5, 101);
+
+    TDynamicVector<double> r = Exp(x);
+
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        double e = std::exp(x[i]);
+        EXPECT_GT(r[i], 0);
+        // абсолютная погрешность - в пределах младшего разряда денормализованных чисел
+        EXPECT_NEAR(e, r[i], std::max(1e-14 * e, std::numeric_limits<double>::denorm_min()));
+    }
+    TDynamicVector<double> tiny(1);
+    tiny[0] = -746;
+    EXPECT_EQ(0, Exp(tiny)[0]);
+}
+
+TEST(TVecMath, exp_returns_subnormal_results_for_float)
+{
+    TDynamicVector<float> x(2);
+    x[0] = -100.0f;
+    x[1] = -105.0f;
+
+    TDynamicVector<float> r = Exp(x);
+
+    EXPECT_NEAR(std::exp(-100.0f), r[0], std::numeric_limits<float>::denorm_min());
+    EXPECT_EQ(0, r[1]);
+}
+
+TEST(TVecMath, balanced_log_is_accurate_for_double)
+{
+    TDynamicVector<double> x = range(1e-3, 1e6, 10001);
+
+    double err = maxRelativeError(x, [](const TDynamicVector<double>& v) { return Log(v); },
+        [](double a) { return std::log(a); });
+
+    EXPECT_LT(err, 1e-14);
+}
+
+TEST(TVecMath, log_handles_special_values)
+{
+    TDynamicVector<double> x(4);
+    x[0] = 0;
+    x[1] = -1;
+    x[2] = 1e-310;
+    x[3] = 1;
+
+    TDynamicVector<double> r = Log(x);
+
+    EXPECT_TRUE(std::isinf(r[0]) && r[0] < 0);
+    EXPECT_TRUE(std::isnan(r[1]));
+    EXPECT_NEAR(std::log(1e-310), r[2], 1e-12);
+    EXPECT_EQ(0, r[3]);
+}
+
+TEST(TVecMath, tanh_and_sigmoid_are_accurate_for_float)
+{
+    TDynamicVector<float> x(2001);
+    for (size_t i = 0; i < x.size(); i++)
+        x[i] = -20.0f + 40.0f * i / 2000;
+
+    double errTanh = maxRelativeError(x, [](const TDynamicVector<float>& v) { return Tanh(v); },
+        [](double a) { return std::tanh(a); });
+    double errSigmoid = maxRelativeError(x, [](const TDynamicVector<float>& v) { return Sigmoid(v); },
+        [](double a) { return 1 / (1 + std::exp(-a)); });
+
+    EXPECT_LT(errTanh, 1e-6);
+    EXPECT_LT(errSigmoid, 1e-6);
+}
+
+TEST(TVecMath, tanh_keeps_precision_near_zero)
+{
+    TDynamicVector<double> x(1);
+    x[0] = 1e-10;
+
+    EXPECT_NEAR(1.0, Tanh(x)[0] / 1e-10, 1e-14);
+}
+
+TEST(TVecMath, can_apply_function_to_matrix_with_policy)
+{
+    TDynamicMatrix<double> m(20);
+    for (int i = 0; i < 20; i++)
+        for (int j = 0; j < 20; j++)
+            m[i][j] = i + j;
+
+    TDynamicMatrix<double> r = Sqrt(exec_par, m);
+
+    for (int i = 0; i < 20; i++)
+        for (int j = 0; j < 20; j++)
+            EXPECT_DOUBLE_EQ(std::sqrt(double(i + j)), r[i][j]);
+}
+
+TEST(TVecMath, precise_accuracy_matches_standard_library)
+{
+    TDynamicVector<double> x = range(-5, 5, 11);
+
+    TDynamicVector<double> r = Exp(exec_par, x, TMathAccuracy::Precise);
+
+    for (size_t i = 0; i < x.size(); i++)
+        EXPECT_EQ(std::exp(x[i]), r[i]);
+}
@@ -308,3 +308,380 @@ TEST(TDynamicVector, cant_multiply_vectors_with_not_equal_size)
     EXPECT_THROW(v1 * v2, std::invalid_argument);
 }
 
+
+TEST(TDynamicVector, parallel_policy_operations_match_sequential_ones)
+{
+    const size_t n = 100000;
+    TDynamicVector<int> v1(n), v2(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        v1[i] = static_cast<int>(i % 100);
+        v2[i] = static_cast<int>(i % 7);
+    }
+
+    EXPECT_EQ(v1 + v2, v1.add(exec_par, v2));
+    EXPECT_EQ(v1 - v2, v1.subtract(exec_par_unseq, v2));
+    EXPECT_EQ(v1 * 3, v1.multiply(exec_par, 3));
+    EXPECT_EQ(v1.multiplyElementwise(v2), v1.multiplyElementwise(exec_par, v2));
+    EXPECT_EQ(v1 * v2, v1.dot(exec_par, v2));
+}
+
+TEST(TDynamicVector, can_sum_vector_with_policy)
+{
+    TDynamicVector<int> v(1000);
+    for (int i = 0; i < 1000; i++)
+    {
+        v[i] = i + 1;
+    }
+
+    EXPECT_EQ(500500, v.sum(exec_seq));
+    EXPECT_EQ(500500, v.sum(exec_par));
+}
+
+TEST(TDynamicVector, can_compute_norm_with_policy)
+{
+    TDynamicVector<double> v(2);
+    v[0] = 3;
+    v[1] = 4;
+
+    EXPECT_DOUBLE_EQ(5.0, v.norm(exec_seq));
+    EXPECT_DOUBLE_EQ(5.0, v.norm(exec_par_det));
+}
+
+TEST(TDynamicVector, deterministic_reductions_do_not_depend_on_thread_count)
+{
+    const size_t n = 1000003;
+    TDynamicVector<double> v1(n), v2(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        v1[i] = 1.0 / (i + 1) * (i % 3 == 0 ? -1e8 : 1.0);
+        v2[i] = static_cast<double>(i % 101) + 0.1;
+    }
+
+    size_t old = TThreadPool::GetConcurrency();
+    TThreadPool::SetConcurrency(1);
+    double dot = v1.dot(exec_par_det, v2);
+    double sum = v1.sum(exec_par_det);
+    double norm = v1.norm(exec_par_det);
+    for (size_t threads : { 2, 3, 8, 128 })
+    {
+        TThreadPool::SetConcurrency(threads);
+        EXPECT_EQ(dot, v1.dot(exec_par_det, v2));
+        EXPECT_EQ(sum, v1.sum(exec_par_det));
+        EXPECT_EQ(norm, v1.norm(exec_par_det));
+    }
+    TThreadPool::SetConcurrency(old);
+}
+
+TEST(TDynamicVector, cant_add_vectors_with_not_equal_size_with_policy)
+{
+    TDynamicVector<int> v1(3);
+    TDynamicVector<int> v2(4);
+
+    EXPECT_THROW(v1.add(exec_par, v2), std::invalid_argument);
+}
+
+TEST(TDynamicVector, can_multiply_add_vectors)
+{
+    TDynamicVector<double> a(3), b(3), c(3);
+    for (int i = 0; i < 3; i++)
+    {
+        a[i] = i + 1;
+        b[i] = 2;
+        c[i] = 10;
+    }
+
+    TDynamicVector<double> res = a.multiplyAdd(b, c);
+
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_DOUBLE_EQ((i + 1) * 2 + 10, res[i]);
+    }
+    EXPECT_EQ(res, a.multiplyAdd(2.0, c));
+    EXPECT_EQ(res, a.multiplyAdd(exec_par, b, c));
+}
+
+TEST(TDynamicVector, cant_multiply_add_vectors_with_not_equal_size)
+{
+    TDynamicVector<int> a(3), b(3), c(4);
+
+    EXPECT_THROW(a.multiplyAdd(b, c), std::invalid_argument);
+}
+
+TEST(TDynamicVector, can_lerp_vectors)
+{
+    TDynamicVector<double> a(2), b(2);
+    a[0] = 0; a[1] = 10;
+    b[0] = 4; b[1] = 20;
+
+    TDynamicVector<double> res = a.lerp(b, 0.25);
+
+    EXPECT_DOUBLE_EQ(1, res[0]);
+    EXPECT_DOUBLE_EQ(12.5, res[1]);
+}
+
+TEST(TDynamicVector, can_clamp_vector)
+{
+    TDynamicVector<int> v(5);
+    for (int i = 0; i < 5; i++)
+    {
+        v[i] = i * 10;
+    }
+
+    TDynamicVector<int> res = v.clamp(5, 25);
+
+    EXPECT_EQ(5, res[0]);
+    EXPECT_EQ(10, res[1]);
+    EXPECT_EQ(25, res[3]);
+    EXPECT_THROW(v.clamp(25, 5), std::invalid_argument);
+}
+
+TEST(TDynamicVector, can_select_by_mask)
+{
+    TDynamicVector<bool> mask(3);
+    TDynamicVector<int> a(3), b(3);
+    mask[1] = true;
+    for (int i = 0; i < 3; i++)
+    {
+        a[i] = 1;
+        b[i] = 2;
+    }
+
+    TDynamicVector<int> res = TDynamicVector<int>::select(mask, a, b);
+
+    EXPECT_EQ(2, res[0]);
+    EXPECT_EQ(1, res[1]);
+    EXPECT_EQ(2, res[2]);
+}
+
+TEST(TDynamicVector, can_map_vector_to_other_type)
+{
+    TDynamicVector<int> v(4);
+    for (int i = 0; i < 4; i++)
+    {
+        v[i] = i;
+    }
+
+    TDynamicVector<double> res = v.map([](int a) { return a * 0.5; });
+
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_DOUBLE_EQ(i * 0.5, res[i]);
+    }
+}
+
+TEST(TDynamicVector, can_zip_vectors_with_function)
+{
+    TDynamicVector<int> v1(3), v2(3);
+    for (int i = 0; i < 3; i++)
+    {
+        v1[i] = i;
+        v2[i] = 10 * i;
+    }
+
+    TDynamicVector<int> res = v1.zipWith(exec_par, v2, [](int a, int b) { return b - a; });
+
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(9 * i, res[i]);
+    }
+    EXPECT_THROW(v1.zipWith(TDynamicVector<int>(4), [](int a, int b) { return a + b; }), std::invalid_argument);
+}
+
+TEST(TDynamicVector, can_transform_reduce_vectors)
+{
+    const size_t n = 100000;
+    TDynamicVector<int> v1(n), v2(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        v1[i] = static_cast<int>(i % 10);
+        v2[i] = static_cast<int>(i % 3);
+    }
+    auto absDiff = [](int a, int b) { return a > b ? a - b : b - a; };
+    auto maxOf = [](int a, int b) { return a > b ? a : b; };
+
+    EXPECT_EQ(9, v1.transformReduce(v2, 0, maxOf, absDiff));
+    EXPECT_EQ(9, v1.transformReduce(exec_par, v2, 0, maxOf, absDiff));
+    EXPECT_EQ(v1 * v2 + 5, v1.transformReduce(exec_par, v2, 5, std::plus<int>(), std::multiplies<int>()));
+}
+
+TEST(TDynamicVector, can_apply_function_in_place)
+{
+    TDynamicVector<int> v(3);
+    for (int i = 0; i < 3; i++)
+    {
+        v[i] = i;
+    }
+
+    v.apply([](int a) { return a * a; }).apply(exec_par, [](int a) { return a + 1; });
+
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(i * i + 1, v[i]);
+    }
+}
+
+TEST(TDynamicVector, can_scan_vector)
+{
+    TDynamicVector<int> v(4);
+    for (int i = 0; i < 4; i++)
+    {
+        v[i] = i + 1;
+    }
+
+    TDynamicVector<int> inc = v.inclusiveScan();
+    TDynamicVector<int> exc = v.exclusiveScan(10);
+
+    EXPECT_EQ(1, inc[0]);
+    EXPECT_EQ(10, inc[3]);
+    EXPECT_EQ(10, exc[0]);
+    EXPECT_EQ(16, exc[3]);
+}
+
+TEST(TDynamicVector, parallel_scan_matches_sequential_one)
+{
+    const size_t n = 200001;
+    TDynamicVector<long long> v(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        v[i] = static_cast<long long>(i % 13);
+    }
+
+    EXPECT_EQ(v.inclusiveScan(), v.inclusiveScan(exec_par));
+    EXPECT_EQ(v.exclusiveScan(7), v.exclusiveScan(exec_par, 7));
+}
+
+TEST(TDynamicVector, can_scan_vector_in_place)
+{
+    const size_t n = 100000;
+    TDynamicVector<long long> v(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        v[i] = 1;
+    }
+
+    v.exclusiveScan(exec_par, v);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        ASSERT_EQ(static_cast<long long>(i), v[i]);
+    }
+}
+
+TEST(TDynamicVector, can_segmented_scan_vector)
+{
+    const size_t n = 100000;
+    TDynamicVector<int> v(n);
+    TDynamicVector<bool> heads(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        v[i] = 1;
+        heads[i] = i % 1000 == 0;
+    }
+
+    TDynamicVector<int> res = v.segmentedInclusiveScan(exec_par, heads);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        ASSERT_EQ(static_cast<int>(i % 1000 + 1), res[i]);
+    }
+    EXPECT_EQ(res, v.segmentedInclusiveScan(heads));
+}
+
+TEST(TDynamicVector, cant_scan_into_vector_with_not_equal_size)
+{
+    TDynamicVector<int> v(3), out(4);
+
+    EXPECT_THROW(v.inclusiveScan(exec_par, out), std::invalid_argument);
+}
+
+TEST(TDynamicVector, copy_is_deep_by_default)
+{
+    TDynamicVector<int> v(10);
+    TDynamicVector<int> c(v);
+
+    EXPECT_FALSE(v.IsCopyOnWrite());
+    EXPECT_FALSE(v.IsShared());
+    EXPECT_NE(static_cast<const TDynamicVector<int>&>(v).data(), static_cast<const TDynamicVector<int>&>(c).data());
+}
+
+TEST(TDynamicVector, copy_on_write_copy_shares_memory)
+{
+    TDynamicVector<int> v(10);
+    v.SetCopyOnWrite(true);
+    TDynamicVector<int> c(v);
+    TDynamicVector<int> a;
+    a = v;
+
+    EXPECT_TRUE(c.IsCopyOnWrite());
+    EXPECT_TRUE(v.IsShared());
+    EXPECT_EQ(static_cast<const TDynamicVector<int>&>(v).data(), static_cast<const TDynamicVector<int>&>(c).data());
+    EXPECT_EQ(static_cast<const TDynamicVector<int>&>(v).data(), static_cast<const TDynamicVector<int>&>(a).data());
+}
+
+TEST(TDynamicVector, copy_on_write_copy_is_made_on_first_write)
+{
+    TDynamicVector<int> v(10);
+    v[3] = 1;
+    v.SetCopyOnWrite(true);
+    TDynamicVector<int> c(v);
+
+    c[3] = 2;
+
+    EXPECT_EQ(1, v[3]);
+    EXPECT_EQ(2, c[3]);
+    EXPECT_FALSE(v.IsShared());
+    EXPECT_FALSE(c.IsShared());
+}
+
+TEST(TDynamicVector, in_place_operations_do_not_change_copy_on_write_copies)
+{
+    TDynamicVector<int> v(100);
+    for (int i = 0; i < 100; i++)
+        v[i] = i;
+    v.SetCopyOnWrite(true);
+    TDynamicVector<int> c1(v), c2(v), c3(v);
+
+    c1.apply(exec_par, [](int x) { return -x; });
+    c2.inclusiveScan(exec_seq, c2);
+    c3.at(5) = 0;
+
+    for (int i = 0; i < 100; i++)
+        EXPECT_EQ(i, v[i]);
+    EXPECT_EQ(-99, c1[99]);
+    EXPECT_EQ(4950, c2[99]);
+    EXPECT_EQ(0, c3[5]);
+}
+
+TEST(TDynamicVector, can_disable_copy_on_write)
+{
+    TDynamicVector<int> v(10);
+    v.SetCopyOnWrite(true);
+    TDynamicVector<int> c(v);
+
+    c.SetCopyOnWrite(false);
+    TDynamicVector<int> d(c);
+
+    EXPECT_FALSE(c.IsCopyOnWrite());
+    EXPECT_FALSE(v.IsShared());
+    EXPECT_NE(static_cast<const TDynamicVector<int>&>(v).data(), static_cast<const TDynamicVector<int>&>(c).data());
+    EXPECT_NE(static_cast<const TDynamicVector<int>&>(c).data(), static_cast<const TDynamicVector<int>&>(d).data());
+}
+
+TEST(TDynamicVector, copy_on_write_copies_can_be_made_from_many_threads)
+{
+    TDynamicVector<int> v(1000);
+    v.SetCopyOnWrite(true);
+
+    ParallelFor(1000, 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+        {
+            TDynamicVector<int> c(v);
+            if (i % 2 == 0)
+                c[i] = 1;
+        }
+    });
+
+    EXPECT_FALSE(v.IsShared());
+    EXPECT_EQ(0, v.sum(exec_seq));
+}
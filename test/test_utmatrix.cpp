@@ -0,0 +1,245 @@
+#include "utmatrix.h"
+
+#include <gtest.h>
+
+#include <stdexcept>
+
+namespace
+{
+TUpperTriangularMatrix<int> makeUpper(size_t n, int seed)
+{
+    TUpperTriangularMatrix<int> m(n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = i; j < n; j++)
+            m(i, j) = static_cast<int>((i * 7 + j * 3 + seed) % 11) - 5;
+    return m;
+}
+}
+
+TEST(TUpperTriangularMatrix, can_create_matrix_with_positive_size)
+{
+    ASSERT_NO_THROW(TUpperTriangularMatrix<int> m(5));
+}
+
+TEST(TUpperTriangularMatrix, throws_when_size_is_zero_or_too_large)
+{
+    EXPECT_THROW(TUpperTriangularMatrix<int>(0), std::out_of_range);
+    EXPECT_THROW(TUpperTriangularMatrix<int>(MAX_MATRIX_SIZE + 1), std::out_of_range);
+}
+
+TEST(TUpperTriangularMatrix, can_set_and_get_elements)
+{
+    TUpperTriangularMatrix<int> m(3);
+    m(0, 2) = 4;
+    m(1, 1) = 5;
+
+    EXPECT_EQ(4, m(0, 2));
+    EXPECT_EQ(5, m(1, 1));
+    EXPECT_EQ(0, static_cast<const TUpperTriangularMatrix<int>&>(m)(2, 0));
+    EXPECT_THROW(m(2, 0), std::out_of_range);
+    EXPECT_THROW(m(0, 3), std::out_of_range);
+}
+
+TEST(TUpperTriangularMatrix, dense_round_trip_keeps_matrix)
+{
+    TUpperTriangularMatrix<int> m = makeUpper(10, 1);
+    TDynamicMatrix<int> d = m.ToDense();
+
+    EXPECT_EQ(0, d[5][2]);
+    EXPECT_EQ(m(2, 5), d[2][5]);
+    EXPECT_EQ(m, TUpperTriangularMatrix<int>(d));
+}
+
+TEST(TUpperTriangularMatrix, throws_when_dense_matrix_is_not_upper_triangular)
+{
+    TDynamicMatrix<int> d(3);
+    d[2][1] = 1;
+
+    EXPECT_THROW(TUpperTriangularMatrix<int>{ d }, std::invalid_argument);
+}
+
+TEST(TUpperTriangularMatrix, sum_and_difference_match_dense)
+{
+    TUpperTriangularMatrix<int> a = makeUpper(20, 1), b = makeUpper(20, 4);
+    TDynamicMatrix<int> da = a.ToDense(), db = b.ToDense();
+
+    EXPECT_EQ(da + db, (a + b).ToDense());
+    EXPECT_EQ(da - db, (a - b).ToDense());
+}
+
+TEST(TUpperTriangularMatrix, throws_when_sizes_differ)
+{
+    TUpperTriangularMatrix<int> a(3), b(4);
+
+    EXPECT_THROW(a + b, std::invalid_argument);
+    EXPECT_THROW(a - b, std::invalid_argument);
+    EXPECT_THROW(a * b, std::invalid_argument);
+}
+
+TEST(TUpperTriangularMatrix, product_with_scalar_matches_dense)
+{
+    TUpperTriangularMatrix<int> a = makeUpper(15, 2);
+    TDynamicMatrix<int> d = a.ToDense();
+
+    EXPECT_EQ(d * 3, (a * 3).ToDense());
+}
+
+TEST(TUpperTriangularMatrix, product_with_vector_matches_dense)
+{
+    TUpperTriangularMatrix<int> a = makeUpper(25, 3);
+    TDynamicVector<int> v(25);
+    for (size_t i = 0; i < 25; i++)
+        v[i] = static_cast<int>(i) - 12;
+
+    EXPECT_EQ(a.ToDense() * v, a * v);
+    EXPECT_EQ(a * v, a.multiply(exec_seq, v));
+}
+
+TEST(TUpperTriangularMatrix, product_is_upper_triangular_and_matches_dense)
+{
+    TUpperTriangularMatrix<int> a = makeUpper(30, 1), b = makeUpper(30, 5);
+    TDynamicMatrix<int> da = a.ToDense(), db = b.ToDense();
+
+    TUpperTriangularMatrix<int> c = a * b;
+
+    EXPECT_EQ(da * db, c.ToDense());
+    EXPECT_EQ(c, a.multiply(exec_seq, b));
+    EXPECT_EQ(c, a.multiply(exec_par_det, b));
+}
+
+TEST(TUpperTriangularMatrix, solve_returns_solution)
+{
+    TUpperTriangularMatrix<double> a(4);
+    for (size_t i = 0; i < 4; i++)
+        for (size_t j = i; j < 4; j++)
+            a(i, j) = i == j ? 2.0 : 1.0;
+    TDynamicVector<double> x(4);
+    for (size_t i = 0; i < 4; i++)
+        x[i] = static_cast<double>(i) + 1;
+
+    EXPECT_EQ(x, a.Solve(a * x));
+}
+
+TEST(TUpperTriangularMatrix, solve_throws_for_singular_matrix)
+{
+    TUpperTriangularMatrix<double> a(2);
+    a(0, 0) = 1;
+    TDynamicVector<double> b(2);
+
+    EXPECT_THROW(a.Solve(b), std::runtime_error);
+}
+
+namespace
+{
+TSymmetricMatrix<int> makeSymmetric(size_t n, int seed)
+{
+    TSymmetricMatrix<int> m(n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = i; j < n; j++)
+            m(i, j) = static_cast<int>((i * 5 + j * 2 + seed) % 9) - 4;
+    return m;
+}
+}
+
+TEST(TSymmetricMatrix, mirrored_elements_are_the_same)
+{
+    TSymmetricMatrix<int> m(3);
+    m(2, 0) = 7;
+
+    EXPECT_EQ(7, m(0, 2));
+    EXPECT_EQ(&m(0, 2), &m(2, 0));
+    EXPECT_THROW(m(3, 0), std::out_of_range);
+}
+
+TEST(TSymmetricMatrix, dense_round_trip_keeps_matrix)
+{
+    TSymmetricMatrix<int> m = makeSymmetric(12, 1);
+    TDynamicMatrix<int> d = m.ToDense();
+
+    EXPECT_EQ(d[3][8], d[8][3]);
+    EXPECT_EQ(m(3, 8), d[8][3]);
+    EXPECT_EQ(m, TSymmetricMatrix<int>(d));
+}
+
+TEST(TSymmetricMatrix, throws_when_dense_matrix_is_not_symmetric)
+{
+    TDynamicMatrix<int> d(3);
+    d[0][1] = 1;
+
+    EXPECT_THROW(TSymmetricMatrix<int>{ d }, std::invalid_argument);
+}
+
+TEST(TSymmetricMatrix, elementwise_operations_match_dense)
+{
+    TSymmetricMatrix<int> a = makeSymmetric(10, 1), b = makeSymmetric(10, 3);
+    TDynamicMatrix<int> da = a.ToDense(), db = b.ToDense();
+
+    EXPECT_EQ(da + db, (a + b).ToDense());
+    EXPECT_EQ(da - db, (a - b).ToDense());
+    EXPECT_EQ(da * 4, (a * 4).ToDense());
+}
+
+TEST(TSymmetricMatrix, product_with_vector_matches_dense)
+{
+    for (size_t n : { 1, 2, 7, 40 })
+    {
+        TSymmetricMatrix<int> a = makeSymmetric(n, 2);
+        TDynamicVector<int> v(n);
+        for (size_t i = 0; i < n; i++)
+            v[i] = static_cast<int>(i % 5) - 2;
+
+        EXPECT_EQ(a.ToDense() * v, a * v);
+        EXPECT_EQ(a * v, a.multiply(exec_seq, v));
+        EXPECT_EQ(a * v, a.multiply(exec_par_det, v));
+    }
+}
+
+TEST(TSymmetricMatrix, deterministic_product_with_vector_does_not_depend_on_thread_count)
+{
+    size_t n = 300;
+    TSymmetricMatrix<double> a(n);
+    TDynamicVector<double> v(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        v[i] = 1.0 / (i + 1);
+        for (size_t j = i; j < n; j++)
+            a(i, j) = (i + 1.0) / (j + 3.0);
+    }
+
+    size_t old = TThreadPool::GetConcurrency();
+    TThreadPool::SetConcurrency(1);
+    TDynamicVector<double> expected = a.multiply(exec_par_det, v);
+    for (size_t threads : { 2, 5, 16, 128 })
+    {
+        TThreadPool::SetConcurrency(threads);
+        EXPECT_EQ(expected, a.multiply(exec_par_det, v));
+    }
+    TThreadPool::SetConcurrency(old);
+
+    TDynamicVector<double> dense = a.ToDense() * v;
+    for (size_t i = 0; i < n; i++)
+        EXPECT_NEAR(dense[i], expected[i], 1e-9);
+}
+
+TEST(TSymmetricMatrix, product_with_matrix_matches_dense)
+{
+    TSymmetricMatrix<int> a = makeSymmetric(70, 4);
+    TDynamicMatrix<int> b(70);
+    for (size_t i = 0; i < 70; i++)
+        for (size_t j = 0; j < 70; j++)
+            b[i][j] = static_cast<int>((i * j) % 7) - 3;
+
+    EXPECT_EQ(a.ToDense() * b, a * b);
+    EXPECT_EQ(a * b, a.multiply(exec_seq, b));
+}
+
+TEST(TSymmetricMatrix, throws_when_sizes_differ)
+{
+    TSymmetricMatrix<int> a(3);
+    TDynamicVector<int> v(4);
+    TDynamicMatrix<int> m(4);
+
+    EXPECT_THROW(a * v, std::invalid_argument);
+    EXPECT_THROW(a * m, std::invalid_argument);
+    EXPECT_THROW(a + TSymmetricMatrix<int>(4), std::invalid_argument);
+}